@@ -26,3 +26,13 @@ option(
   "Enable compilation and linking to wxVTK24" 
   ON
 )
+
+option(
+  MOLOVOL_BUILD_GUI
+  "Build the application. Without it, only the library molovol_core is built, which does not need wxWidgets"
+  ON
+)
+
+if (NOT MOLOVOL_BUILD_GUI)
+  set(MOLOVOL_RENDERER OFF)
+endif()
@@ -1,25 +1,43 @@
-
-# List of source files
-set(SOURCES
+# List of source files of the calculation engine, which does not depend on wxWidgets
+set(CORE_SOURCES
   src/atom.cpp
+  src/atomclassify.cpp
   src/atomtree.cpp
-  src/base_guicontrol.cpp
-  src/base_cmdline.cpp
-  src/base_constr.cpp
-  src/base_event.cpp
-  src/base_guicontrol.cpp
-  src/base_init.cpp
+  src/batch.cpp
   src/cavity.cpp
-  src/controller.cpp
   src/crystallographer.cpp
+  src/distancetransform.cpp
   src/griddata.cpp
   src/importmanager.cpp
   src/misc.cpp
   src/model.cpp
   src/model_filereading.cpp
   src/model_outputfiles.cpp
+  src/profile.cpp
+  src/progress.cpp
+  src/reporter.cpp
+  src/searchindex.cpp
   src/space.cpp
-  src/special_chars.cpp
+  src/space_cavities.cpp
+  src/sparsegrid.cpp
+  src/tiling.cpp
   src/vector.cpp
   src/voxel.cpp
 )
+
+# List of source files of the application
+set(SOURCES
+  src/base_guicontrol.cpp
+  src/base_cmdline.cpp
+  src/base_constr.cpp
+  src/base_event.cpp
+  src/base_init.cpp
+  src/controller.cpp
+  src/special_chars.cpp
+)
+
+# the atom classification kernels only give identical results on every instruction set,
+# if multiplications and additions are not fused
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+  set_source_files_properties(src/atomclassify.cpp PROPERTIES COMPILE_OPTIONS -ffp-contract=off)
+endif()
@@ -1,25 +1,20 @@
 
 enable_testing()
 
-# Create a MoloVol library for the test sources to use
-set(TEST_SOURCES
-  src/atom.cpp
-  src/atomtree.cpp
-  src/vector.cpp
-  src/importmanager.cpp
-  src/crystallographer.cpp
-  src/misc.cpp
-)
-
-add_library(mvl SHARED ${TEST_SOURCES})
-target_include_directories(mvl PUBLIC ./)
-target_compile_definitions(mvl PRIVATE LIBRARY_BUILD)
-
 set(TEST_NAMES
   cut_off_string
   struct_atom
   class_vector
   class_atomtree
+  class_tilescheduler
+  class_container3d
+  atom_classification
+  struct_searchindex
+  distance_transform
+  progress_token
+  class_profiler
+  headless_calculation
+  batch_jobs
 )
 
 set(MOLOVOL_TEST_DIR ${CMAKE_SOURCE_DIR}/test)
@@ -31,8 +26,17 @@ foreach(TN IN ITEMS ${TEST_NAMES})
   add_executable(${TEST_EXE_NAME} ${MOLOVOL_TEST_DIR}/${TEST_SRC_NAME})
   set_target_properties(${TEST_EXE_NAME} PROPERTIES RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/testbin)
   target_include_directories(${TEST_EXE_NAME} PUBLIC ${MOLOVOL_TEST_DIR})
-  target_link_libraries(${TEST_EXE_NAME} mvl)
+  target_compile_definitions(${TEST_EXE_NAME} PRIVATE MOLOVOL_INPUT_DIR="${CMAKE_SOURCE_DIR}/inputfile")
+  target_link_libraries(${TEST_EXE_NAME} molovol_core)
   add_test(NAME ${TN} COMMAND ${TEST_EXE_NAME})
 
 endforeach()
 
+# Benchmarks of the full calculation. they are run by hand from the build directory, so that the
+# resource files are found:
+#   ./testbin/performance_test --benchmark_filter=BM_Structure
+add_executable(performance_test ${MOLOVOL_TEST_DIR}/performance_test.cpp)
+set_target_properties(performance_test PROPERTIES RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/testbin)
+target_compile_definitions(performance_test PRIVATE MOLOVOL_INPUT_DIR="${CMAKE_SOURCE_DIR}/inputfile")
+target_link_libraries(performance_test molovol_core benchmark::benchmark)
+add_test(NAME performance_smoke COMMAND performance_test --benchmark_filter=BM_VectorOperations|BM_AtomOperations)
@@ -0,0 +1,39 @@
+#ifndef ATOMCLASSIFY_H
+
+#define ATOMCLASSIFY_H
+
+#include "vector.h"
+#include <vector>
+#include <array>
+#include <cstddef>
+
+// positions and radii of a list of atoms, stored per dimension so that several atoms can
+// be compared against a voxel at once
+struct AtomBlock{
+  std::array<std::vector<double>,3> pos;
+  std::vector<double> rad;
+
+  size_t size() const {return rad.size();}
+  void clear();
+  void push_back(const Vector&, const double);
+};
+
+// appends the atoms of the candidates whose surface is closer to pos than the reach,
+// keeping their order
+void filterAtoms(AtomBlock&, const AtomBlock&, const Vector& pos, const double reach);
+
+// instruction sets for which a classification kernel exists
+enum class AtomKernel{scalar, avx2, avx512};
+
+bool isKernelSupported(const AtomKernel);
+// the fastest kernel supported by this cpu, determined once
+AtomKernel bestAtomKernel();
+
+// determines a voxel's type from its relation to all atoms of the block, as if the atoms were
+// evaluated one after the other in the order of the block, starting from the voxel's current type.
+// the distances are compared as squares, in the same order of operations as in Vector::squared(),
+// so that all kernels yield the same result
+char classifyAtoms(const AtomBlock&, const Vector& pos_vxl, const double rad_vxl, const double rad_probe,
+    const char type, const bool masking_mode, const AtomKernel = bestAtomKernel());
+
+#endif
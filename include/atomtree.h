@@ -3,63 +3,82 @@
 #define ATOMTREE_H
 
 #include "atom.h"
+#include "vector.h"
 #include <vector>
+#include <array>
 #include <string>
 
-class AtomTree;
-class AtomNode{
-  public:
-    AtomNode(AtomTree*, size_t, AtomNode* left_node, AtomNode* right_node);
-    ~AtomNode();
- 
-    const AtomNode* getLeftChild() const;
-    const AtomNode* getRightChild() const;
-    AtomNode* getLeftChild();
-    AtomNode* getRightChild();
-    Atom& getAtom() const;
-    size_t getAtomId() const;
-
-    void print();
-  private:
-    // TODO: Reevaluate whether each node needs to know their parent tree. This
-    // is only used for accessing atoms from nodes directly which is only used
-    // by the voxel class. Atom access could go through atom tree directly
-    AtomTree* _parent_tree;
-    AtomNode* _left_child;
-    AtomNode* _right_child;
-    size_t _atom_id;
-};
-
+// 3-d tree of atoms without any pointers. the atoms are sorted such that the node of the
+// atoms in [first,end) is the median atom at first + (end-first)/2. the atoms in front of the
+// median form its left subtree, the atoms behind it form its right subtree. the dimension
+// along which a subtree is split cycles through x, y and z with increasing depth.
+// positions and radii are stored per dimension in tree order. every node also knows the
+// bounding box of the atom centres in its subtree and the largest radius among these atoms,
+// so that subtrees that are too far from a point can be skipped as a whole
 class AtomTree{
   public:
-    friend AtomNode;
-
-    typedef Atom::num_type num_type;  
+    typedef Atom::num_type num_type;
     typedef Atom::pos_type pos_type;
 
+    // a subtree, identified by its range of atoms
+    struct Range{
+      size_t first;
+      size_t end;
+      char dim;
+
+      bool empty() const {return first >= end;}
+      size_t node() const {return first + (end-first)/2;}
+      Range left() const {return {first, node(), char((dim+1)%3)};}
+      Range right() const {return {node()+1, end, char((dim+1)%3)};}
+    };
+
     AtomTree();
     AtomTree(const std::vector<Atom>& list_of_atoms);
-    ~AtomTree();
-    // TODO: Move and copy operators
-    
-    const AtomNode* getRoot() const;
+
+    Range getRoot() const;
 
     const double getMaxRad() const;
+    // atoms in tree order, i.e. the node id is the index of an atom in this list
     const std::vector<Atom>& getAtomList() const;
 
+    // data of the atom at a node
+    num_type getCoordinate(const size_t node, const char dim) const {return _pos[dim][node];}
+    Vector getPosVec(const size_t node) const {return Vector(_pos[0][node], _pos[1][node], _pos[2][node]);}
+    num_type getRad(const size_t node) const {return _rad[node];}
+
+    // data of the subtree below a node, including the node itself
+    num_type getSubtreeMaxRad(const size_t node) const {return _subtree_max_rad[node];}
+    std::array<pos_type,2> getBoundingBox(const size_t node) const {return {_box_min[node], _box_max[node]};}
+    // squared distance between a point and the bounding box of a subtree, zero if the point is inside of the box.
+    // never larger than the squared distance to any of the subtree's atoms, see Vector::squared()
+    num_type squaredDistToBox(const size_t node, const Vector& pos) const {
+      num_type dist = 0;
+      for (char dim = 0; dim < 3; dim++){
+        num_type gap = 0;
+        if (pos[dim] < _box_min[node][dim]){gap = _box_min[node][dim] - pos[dim];}
+        else if (pos[dim] > _box_max[node][dim]){gap = pos[dim] - _box_max[node][dim];}
+        dist += gap * gap;
+      }
+      return dist;
+    }
+
     std::vector<size_t> listAllWithin(Atom::pos_type, const double) const;
 
     void print() const;
   private:
-    AtomNode* _root;
     double _max_rad;
     std::vector<Atom> _atom_list;
-    
-    AtomNode* buildTree(size_t, size_t, char);
-  
-    std::vector<Atom>& getAtomList();
-    void quicksort(const size_t, const size_t, const char);
-    void swap(Atom&, Atom&);
+    std::array<std::vector<num_type>,3> _pos;
+    std::vector<num_type> _rad;
+    std::vector<num_type> _subtree_max_rad;
+    std::vector<pos_type> _box_min;
+    std::vector<pos_type> _box_max;
+
+    void buildTree(std::vector<size_t>&, const std::array<std::vector<num_type>,3>&, const Range&);
+    void storeNodeData();
+    void calcSubtreeBounds(const Range&);
+    void listAllWithin(std::vector<size_t>&, const Range&, const Vector&, const double) const;
+    void print(const Range&) const;
 };
 
 #endif
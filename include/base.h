@@ -17,7 +17,6 @@
 #include <wx/cmdline.h>
 #include <wx/statusbr.h>
 #include <wx/thread.h>
-#include <wx/msgqueue.h>
 #include <wchar.h>
 #include <string>
 #include <iostream>
@@ -46,8 +45,7 @@ class MainApp: public wxApp
 
 wxDECLARE_EVENT(wxEVT_COMMAND_WORKERTHREAD_COMPLETED, wxThreadEvent);
 
-template <typename> class Container3D;
-class Voxel;
+class Space;
 class RenderFrame;
 struct Atom;
 
@@ -66,10 +64,9 @@ class MainFrame: public wxFrame, public wxThreadHelper
     void extSetStatus(const std::string);
     void extSetProgressBar(const int);
     void extDisplayCavityList(const GridData&);
-    void extRenderSurface(const Container3D<Voxel>&, const std::array<double,3>, const double, 
-        const bool, const unsigned char, const std::vector<Atom>&);
+    void extRenderSurface(const Space&, const std::array<double,3>, const double, 
+        const bool, const size_t, const std::vector<Atom>&);
 
-    bool receivedAbortCommand();
 
     void extOpenErrorDialog(const int, const std::string&);
 
@@ -88,7 +85,7 @@ class MainFrame: public wxFrame, public wxThreadHelper
     bool getMakeSurfaceMap();
     bool getMakeCavityMaps();
     std::string getOutputDir();
-    const Container3D<Voxel>& getSurfaceData() const;
+    const Space& getSurfaceData() const;
     void enableGuiElements(bool inp); // method to turn interactable gui elements on or off
 
     void displayAtomList(std::vector<std::tuple<std::string, int, double>> symbol_number_radius);
@@ -110,8 +107,8 @@ class MainFrame: public wxFrame, public wxThreadHelper
     void setStatus(const std::string);
     void setProgressBar(const int);
     void displayCavityList(const GridData&);
-    void renderSurface(const Container3D<Voxel>&, const std::array<double,3>, 
-      const double, const std::pair<bool,unsigned char>);
+    void renderSurface(const Space&, const std::array<double,3>, 
+      const double, const std::pair<bool,size_t>);
     void renderMolecule(const std::vector<Atom>&);
 
     void openErrorDialog(const std::pair<int,std::string>&);
@@ -122,7 +119,6 @@ class MainFrame: public wxFrame, public wxThreadHelper
     RenderFrame* m_renderWin;
 #endif
 
-    wxMessageQueue<bool>* _abort_q;
     wxStatusBar* statusBar;
 
     wxPanel* preCalcPanel;
@@ -188,7 +184,6 @@ class MainFrame: public wxFrame, public wxThreadHelper
           wxTextCtrl* dirpickerText;
           wxButton* dirpickerButton;
 
-    void InitMessageQueue();
     // set and manipulate gui interactivity
     void InitDefaultStates();
     std::map<wxWindow*, bool> default_states;
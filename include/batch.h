@@ -0,0 +1,37 @@
+#ifndef BATCH_H
+
+#define BATCH_H
+
+#include "model.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <istream>
+#include <ostream>
+
+// one calculation of a batch. a job is given as a flat JSON object in a single line, whose keys are
+// the long names of the command line options, e.g.
+//   {"id":"cage","file-structure":"cage.cif","radius":1.2,"radius2":3,"grid":0.2,"unitcell":true}
+// in addition, "radii" maps element symbols to radii that replace the elements file and "elements"
+// lists the included elements. the id is returned with the result, so that results can be matched to
+// jobs. like on the command line, "file-structure", "radius" and "grid" are required and two-probe mode
+// is used when "radius2" is given
+struct BatchJob{
+  std::string id;
+  CalcParameters param;
+};
+
+// reads a job from a line of the job list. returns false and describes the problem, if the line is
+// not a valid job
+bool parseBatchJob(const std::string& line, BatchJob& job, std::string& error);
+
+// result of a job as a JSON object in a single line. the keys of the volumes and surfaces are the
+// names of the display options of the command line
+std::string batchResultToJson(const BatchJob&, CalcReportBundle&, const std::vector<std::pair<int,std::string>>& errors);
+
+// runs every job of the stream and writes one result line per job as soon as it is finished. all jobs
+// share one model, so that the elements file, the space groups and the neighbour search tables are
+// only read or computed once. empty lines are skipped. returns the number of failed jobs
+unsigned runBatch(std::istream& jobs, std::ostream& results);
+
+#endif
@@ -8,11 +8,15 @@
 #include <string>
 
 struct Cavity{
+  // cavity ids are stored in single byte planes. only when more than 255 cavities are found, ids are
+  // moved to planes of this type (see Space::enableWideIDs). the type limits the number of cavities
+  typedef unsigned short id_type;
+
   Cavity() = default;
-  Cavity(unsigned char id, int n_entrances) : id(id), n_entrances(n_entrances), core_vol(0), shell_vol(0), surf_core(0), surf_shell(0){};
-  Cavity(unsigned char id, double core_vol, double shell_vol, std::array<double,3> min_bound, std::array<double,3> max_bound, std::array<unsigned int,3> min_index, std::array<unsigned int,3> max_index) :
+  Cavity(id_type id, int n_entrances) : id(id), n_entrances(n_entrances), core_vol(0), shell_vol(0), surf_core(0), surf_shell(0){};
+  Cavity(id_type id, double core_vol, double shell_vol, std::array<double,3> min_bound, std::array<double,3> max_bound, std::array<unsigned int,3> min_index, std::array<unsigned int,3> max_index) :
     id(id), n_entrances(0), core_vol(core_vol), shell_vol(shell_vol), min_bound(min_bound), max_bound(max_bound), min_index(min_index), max_index(max_index), surf_core(0), surf_shell(0){};
-  unsigned char id; // the number assigned to core and shell voxels belonging to this cavity
+  id_type id; // the number assigned to core and shell voxels belonging to this cavity
   int n_entrances;
   double core_vol;
   double shell_vol;
@@ -7,7 +7,71 @@
 #include <array>
 #include <vector>
 
-template <class T>
+// layouts determine the order in which the elements of a Container3D are stored. a layout
+// converts the xyz index of an element into its position in memory and back
+
+// x is the fastest running index, followed by y and z
+struct RowMajorLayout{
+  unsigned long getPos(const unsigned long x, const unsigned long y, const unsigned long z,
+      const std::array<unsigned long,3>& n) const {
+    return (z * n[1] + y) * n[0] + x;
+  }
+  std::array<unsigned long,3> getCoord(const unsigned long pos, const std::array<unsigned long,3>& n) const {
+    return {pos % n[0], (pos / n[0]) % n[1], pos / (n[0] * n[1])};
+  }
+};
+
+// the elements are grouped into cubic blocks with an edge length of 2^block_bits, which are stored one after
+// the other in row major order. inside a block, the elements follow the Morton (Z-order) curve, i.e. the bits
+// of x, y and z are interleaved. if the blocks are the top level voxels of an octree and each level has one
+// block bit less than the level below, the eight subvoxels of the voxel at position i are at positions 8i to 8i+7
+struct MortonLayout{
+  MortonLayout() = default;
+  explicit MortonLayout(const unsigned bits) : block_bits(bits) {
+    assert(block_bits <= 21);
+  }
+
+  unsigned long getPos(const unsigned long x, const unsigned long y, const unsigned long z,
+      const std::array<unsigned long,3>& n) const {
+    const unsigned long mask = (1ul << block_bits) - 1;
+    const unsigned long block = ((z >> block_bits) * (n[1] >> block_bits) + (y >> block_bits)) * (n[0] >> block_bits) + (x >> block_bits);
+    return (block << (3*block_bits)) | spreadBits(x & mask) | (spreadBits(y & mask) << 1) | (spreadBits(z & mask) << 2);
+  }
+  std::array<unsigned long,3> getCoord(const unsigned long pos, const std::array<unsigned long,3>& n) const {
+    const unsigned long block = pos >> (3*block_bits);
+    const unsigned long n_blocks_x = n[0] >> block_bits;
+    const unsigned long n_blocks_y = n[1] >> block_bits;
+    return {((block % n_blocks_x) << block_bits) | compactBits(pos),
+            (((block / n_blocks_x) % n_blocks_y) << block_bits) | compactBits(pos >> 1),
+            ((block / (n_blocks_x * n_blocks_y)) << block_bits) | compactBits(pos >> 2)};
+  }
+
+  unsigned block_bits = 0;
+
+  private:
+    // inserts two zero bits after each of the lowest 21 bits
+    static unsigned long spreadBits(unsigned long v){
+      v &= 0x1fffff;
+      v = (v | v << 32) & 0x1f00000000ffff;
+      v = (v | v << 16) & 0x1f0000ff0000ff;
+      v = (v | v << 8) & 0x100f00f00f00f00f;
+      v = (v | v << 4) & 0x10c30c30c30c30c3;
+      v = (v | v << 2) & 0x1249249249249249;
+      return v;
+    }
+    // reverse of spreadBits(), restricted to the bits inside of a block
+    unsigned long compactBits(unsigned long v) const {
+      v &= 0x1249249249249249 & ((1ul << (3*block_bits)) - 1);
+      v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3;
+      v = (v ^ (v >> 4)) & 0x100f00f00f00f00f;
+      v = (v ^ (v >> 8)) & 0x1f0000ff0000ff;
+      v = (v ^ (v >> 16)) & 0x1f00000000ffff;
+      v = (v ^ (v >> 32)) & 0x1fffff;
+      return v;
+    }
+};
+
+template <class T, class Layout = RowMajorLayout>
 class Container3D{
   public:
     Container3D() = default;
@@ -19,35 +83,41 @@ class Container3D{
       _n_elements[2] = z;
     }
 
-    Container3D(const std::array<unsigned long int,3> steps){
+    Container3D(const std::array<unsigned long int,3> steps, const Layout layout = Layout()){
       _data = std::vector(steps[0]*steps[1]*steps[2],T());
       _n_elements = steps;
+      _layout = layout;
     }
     
-    Container3D(const std::array<unsigned int,3> steps) 
-      : Container3D((unsigned long) steps[0], (unsigned long) steps[1], (unsigned long) steps[2]){}
+    Container3D(const std::array<unsigned int,3> steps, const Layout layout = Layout())
+      : Container3D(std::array<unsigned long,3>({steps[0], steps[1], steps[2]}), layout){}
     
     /////////////
     // GETTERS //
     /////////////
-    // Single index getter
+    // Single index getter, the index is the position in memory (see Layout)
     T& getElement(const unsigned long int i){return _data[i];}
 
     // XYZ index getter
     template<std::integral INT>
     T& getElement(const INT x, const INT y, const INT z){
-      return _data[z * _n_elements[0] * _n_elements[1] + y * _n_elements[0] + x];
+      return _data[_layout.getPos(x, y, z, _n_elements)];
     }
 
     template<std::integral INT>
     const T& getElement(const INT x, const INT y, const INT z) const {
-      return _data[z * _n_elements[0] * _n_elements[1] + y * _n_elements[0] + x];
+      return _data[_layout.getPos(x, y, z, _n_elements)];
     }
 
     // These functions should be a template function
     template<std::integral INT>
     T& getElement(const std::array<INT,3> coord){
-      return _data[coord[2] * _n_elements[0] * _n_elements[1] + coord[1] * _n_elements[0] + coord[0]];
+      return _data[_layout.getPos(coord[0], coord[1], coord[2], _n_elements)];
+    }
+
+    template<std::integral INT>
+    const T& getElement(const std::array<INT,3> coord) const {
+      return _data[_layout.getPos(coord[0], coord[1], coord[2], _n_elements)];
     }
 
     template <typename Q = unsigned long>
@@ -58,10 +128,25 @@ class Container3D{
       }
       return arr;
     }
+
+    // raw access for loops that stream through the data in memory order. getCoord() converts
+    // a position in memory to the xyz index of the element
+    T* data(){return _data.data();}
+    const T* data() const {return _data.data();}
+
+    std::array<unsigned long int,3> getCoord(const unsigned long int pos) const {
+      return _layout.getCoord(pos, _n_elements);
+    }
+
+    template<std::integral INT>
+    unsigned long int getPos(const std::array<INT,3> coord) const {
+      return _layout.getPos(coord[0], coord[1], coord[2], _n_elements);
+    }
   
   private:
     std::vector<T> _data;
     std::array<unsigned long int,3> _n_elements;
+    Layout _layout;
 };
 
 #endif
@@ -0,0 +1,18 @@
+#ifndef DISTANCETRANSFORM_H
+
+#define DISTANCETRANSFORM_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// largest squared distance that the transform stores. larger distances are stored as this value
+constexpr uint16_t s_max_sq_dist = 0xFFFF;
+
+// exact squared euclidean distance transform of a grid in row major order (x changes fastest), using
+// separable passes along x, y and z (Felzenszwalb and Huttenlocher). on input each element is 0 for a
+// source and s_max_sq_dist for every other element. on output each element holds the squared distance
+// to the closest source in units of the grid step, or s_max_sq_dist if that distance is not smaller
+void squaredDistanceTransform(std::vector<uint16_t>&, const std::array<unsigned long,3>&);
+
+#endif
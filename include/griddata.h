@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+class Reporter;
+
 struct SomeText{
   SomeText(std::string str, std::wstring wstr) : str(str), wstr(wstr){}
   SomeText(std::string str) : SomeText(str, L"") {}
@@ -44,7 +46,7 @@ struct GridData{
   size_t getNumberCols() const;
   unsigned char getFormat(const size_t) const;
   bool hideCol(const int) const;
-  void print() const;
+  void print(Reporter&) const;
   std::string getValue(const size_t, const size_t) const;
   std::vector<std::string> getRow(const size_t) const;
   std::string getHeader(const size_t) const;
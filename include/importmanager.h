@@ -9,6 +9,8 @@
 #include <map>
 #include <utility>
 
+class Reporter;
+
 // The import manager is an external component that compartmentalises the code used for
 // importing data. It works for the Model class.
 namespace ImportMngr{
@@ -30,10 +32,10 @@ namespace ImportMngr{
     std::vector<double> sym_matrix_fraction;
   };
 
-  // Main functions
-  std::vector<Atom> readFileXYZ(const std::string&);
-  std::pair<std::vector<Atom>,UnitCell> readFilePDB(const std::string&, bool);
-  std::pair<std::vector<Atom>,UnitCell> readFileCIF(const std::string&);
+  // Main functions. problems with the file are sent to the reporter, unless it is a nullptr
+  std::vector<Atom> readFileXYZ(const std::string&, Reporter* =nullptr);
+  std::pair<std::vector<Atom>,UnitCell> readFilePDB(const std::string&, bool, Reporter* =nullptr);
+  std::pair<std::vector<Atom>,UnitCell> readFileCIF(const std::string&, Reporter* =nullptr);
   
   // Aux functions
   std::string strToValidSymbol(std::string str, signed=0);
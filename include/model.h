@@ -7,6 +7,8 @@
 #include "space.h"
 #include "cavity.h"
 #include "importmanager.h"
+#include "profile.h"
+#include "reporter.h"
 #include <iostream>
 #include <vector>
 #include <map>
@@ -26,6 +28,10 @@ struct CalcReportBundle{
   // parameters for calculation
   double grid_step;
   int max_depth;
+  unsigned n_threads = 1; // 0 for all available cores
+  bool sparse_grid = false; // only allocate subvoxels of mixed voxels
+  bool distance_transform = false; // skip empty neighbour shells in the shell vs void evaluation
+  bool profile = false; // collect counters of the work done in the calculation
   double r_probe1;
   double r_probe2;
   std::vector<std::string> included_elements;
@@ -51,16 +57,41 @@ struct CalcReportBundle{
   double getSurfProbeAccessible(){return surf_probe_accessible;}
   // cavity volumes and surfaces
   std::vector<Cavity> cavities;
-  double getCavVolume(const unsigned char i){return cavities[i].getVolume();}
-  std::array<double,3> getCavCentre(const unsigned char);
-  std::array<double,3> getCavCenter(const unsigned char i){return getCavCentre(i);}
-  double getCavSurfCore(const unsigned char i) const {return cavities[i].getSurfCore();}
-  double getCavSurfShell(const unsigned char i) const {return cavities[i].getSurfShell();}
+  double getCavVolume(const size_t i){return cavities[i].getVolume();}
+  std::array<double,3> getCavCentre(const size_t);
+  std::array<double,3> getCavCenter(const size_t i){return getCavCentre(i);}
+  double getCavSurfCore(const size_t i) const {return cavities[i].getSurfCore();}
+  double getCavSurfShell(const size_t i) const {return cavities[i].getSurfShell();}
   // time
   std::vector<double> elapsed_seconds;
   void addTime(const double t){elapsed_seconds.push_back(t);}
   double getTime(const unsigned i){return elapsed_seconds[i];}
   double getTime();
+  // wall and cpu time of every stage, and the counters if profiling is enabled
+  std::vector<StageTime> stage_times;
+  ProfileCounts counters;
+};
+
+// parameters of a calculation without user interface, see Model::calculate(). elements in the radius
+// map are given that radius instead of the radius from the elements file. an empty list of included
+// elements includes all elements of the structure
+struct CalcParameters{
+  std::string atom_file_path;
+  std::string elem_file_path; // empty for the elements file in the resource folder
+  bool inc_hetatm = false;
+  bool analyze_unit_cell = false;
+  bool calc_surface_areas = false;
+  bool probe_mode = false;
+  double r_probe1 = 1.2;
+  double r_probe2 = 3;
+  double grid_step = 0.1;
+  int max_depth = 4;
+  unsigned n_threads = 1;
+  bool sparse_grid = false;
+  bool distance_transform = false;
+  bool profile = false;
+  std::unordered_map<std::string, double> radius_map;
+  std::vector<std::string> included_elements;
 };
 
 namespace ImportMngr{struct UnitCell;}
@@ -74,6 +105,20 @@ class Model{
   typedef ImportMngr::UnitCell UnitCell;
   typedef std::vector<std::tuple<std::string, double, double, double>> RawAtomData;
   public:
+    static std::string getVersion(){return s_version;}
+    static std::string getDefaultElemPath();
+
+    // receives the messages of the calculation and holds its abort token. without a reporter set,
+    // the model uses its own reporter, which keeps the error messages (see Reporter)
+    void setReporter(Reporter& reporter){_reporter = &reporter;}
+    Reporter& getReporter(){return *_reporter;}
+
+    // imports the structure and runs the calculation without user interface or output files.
+    // the elements file is only imported again, if its path differs from the previous calculation.
+    // errors are sent to the reporter and the returned report is marked as not successful. calculations
+    // of different models must not run at the same time, since the voxels share static state
+    CalcReportBundle calculate(const CalcParameters&);
+
     // elements file import
     bool importElemFile(const std::string&);
     std::unordered_map<std::string, double> extractRadiusMap(const std::string&);
@@ -93,7 +138,7 @@ class Model{
     void writeCavitiesMaps(const std::string);
     void writeSurfaceMap(const std::string, double, std::array<unsigned long int,3>, 
         std::array<double,3>, std::array<unsigned int,3>, std::array<unsigned int,3>, 
-        const bool=false, const unsigned char=0);
+        const bool=false, const size_t=0);
 
     std::vector<std::string> listElementsInStructure();
 
@@ -107,7 +152,7 @@ class Model{
     CalcReportBundle generateData();
     CalcReportBundle generateVolumeData();
     CalcReportBundle generateSurfaceData();
-    const Container3D<Voxel>& getSurfaceData() const;
+    const Space& getSurfaceData() const;
     std::array<double,3> getCellOrigin() const;
     const AtomTree& getAtomTree() const;
 
@@ -131,6 +176,14 @@ class Model{
     void setProbeRad1(double r){_data.r_probe1 = r;}
     double getProbeRad2(){return _data.r_probe2;}
     void setProbeRad2(double r){_data.r_probe2 = r;}
+    unsigned getNumThreads(){return _data.n_threads;}
+    void setNumThreads(const unsigned n){_data.n_threads = n;}
+    bool optionSparseGrid(){return _data.sparse_grid;}
+    void toggleSparseGrid(bool state){_data.sparse_grid = state;}
+    bool optionDistanceTransform(){return _data.distance_transform;}
+    void toggleDistanceTransform(bool state){_data.distance_transform = state;}
+    bool optionProfile(){return _data.profile;}
+    void toggleProfile(bool state){_data.profile = state;}
     bool optionProbeMode(){return _data.probe_mode;}
     void toggleProbeMode(bool state){_data.probe_mode = state;}
     bool optionIncludeHetatm(){return _data.inc_hetatm;}
@@ -139,6 +192,11 @@ class Model{
     bool optionCalcSurfaceAreas(){return _data.calc_surface_areas;}
 
   private:
+    inline static const std::string s_version = "1.2.0";
+    inline static const std::string s_elem_file = "elements.txt";
+
+    Reporter _own_reporter;
+    Reporter* _reporter = &_own_reporter;
     CalcReportBundle _data;
     std::string _time_stamp; // stores the time when the calculation was run for output folder and report
     std::string _output_folder = "."; // default folder is the program folder but it is changed with the output file routine
@@ -150,6 +208,8 @@ class Model{
     std::vector<int> _sym_matrix_XYZ;
     std::vector<double> _sym_matrix_fraction;
     std::unordered_map<std::string, double> _radius_map;
+    std::string _elem_file_path; // elements file of the last calculation started with calculate()
+    std::unordered_map<std::string, double> _elem_file_radius_map; // radii as read from that file
     std::unordered_map<std::string, double> _elem_weight;
     std::unordered_map<std::string, int> _elem_Z;
     std::vector<Atom> _atoms;
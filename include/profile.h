@@ -0,0 +1,64 @@
+#ifndef PROFILE_H
+
+#define PROFILE_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// counters of the work done during a calculation. they are only updated while profiling is enabled
+struct ProfileCounts{
+  static constexpr size_t s_n_lvls = 32;
+
+  std::array<uint64_t,s_n_lvls> split_vxls = {}; // voxels split, by level
+  uint64_t tree_nodes = 0; // atom tree nodes visited by the search for close atoms
+  uint64_t shells_scanned = 0; // neighbour shells scanned by the search for probe cores
+  uint64_t flood_stack_max = 0; // largest size of a flood fill stack. not a sum, but a maximum
+
+  ProfileCounts& operator+=(const ProfileCounts&);
+};
+
+// wall and cpu time of one stage of a calculation. the cpu time is the time of all threads of the process
+struct StageTime{
+  std::string name;
+  double wall_seconds = 0;
+  double cpu_seconds = 0;
+};
+
+// collects the stage times and the counters of a calculation. hot loops update the counters of their
+// own thread, which are merged when the thread ends or when the counters are collected
+class Profiler{
+  public:
+    static void enable(const bool);
+    static bool isEnabled(){return s_enabled.load(std::memory_order_relaxed);}
+    // clears the stages and the counters before a new calculation
+    static void reset();
+    // counters of the calling thread, nullptr while profiling is disabled
+    static ProfileCounts* counts(){return isEnabled()? &threadCounts() : nullptr;}
+    // counters of all threads that have ended and of the calling thread
+    static ProfileCounts collectCounts();
+    static std::vector<StageTime> collectStages();
+    static std::string toJson(const std::vector<StageTime>&, const ProfileCounts&);
+
+    // measures the time from its construction to its destruction as one stage
+    class ScopedStage{
+      public:
+        explicit ScopedStage(const std::string&);
+        ~ScopedStage();
+      private:
+        std::string _name;
+        std::chrono::steady_clock::time_point _wall_start;
+        double _cpu_start;
+    };
+
+  private:
+    static inline std::atomic<bool> s_enabled = false;
+
+    static ProfileCounts& threadCounts();
+    static void addStage(const StageTime&);
+};
+
+#endif
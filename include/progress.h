@@ -0,0 +1,51 @@
+#ifndef PROGRESS_H
+
+#define PROGRESS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// stages of a calculation that report their progress separately
+enum class CalcStage : unsigned char{atoms, cavities, shell, volume, surface, count};
+
+// shared by a calculation, its worker threads and the thread that controls the calculation. any
+// thread may request the abort or report finished work units at any time. all members are atomics,
+// so neither locks nor allocations are needed
+class ProgressToken{
+  public:
+    // number of calls of sampleAbort() per thread between two reads of the abort flag
+    static constexpr unsigned s_sample_interval = 64;
+
+    ProgressToken();
+
+    // clears the abort flag and all counters before a new calculation
+    void reset();
+    void requestAbort();
+    bool isAborted() const {return _aborted.load(std::memory_order_relaxed);}
+    // for hot loops and recursions. only every s_sample_interval-th call of a thread reads the abort
+    // flag, all other calls return false. callers therefore notice an abort a few calls late
+    bool sampleAbort() const;
+
+    // the current stage is the stage that addWork() and addProgress() count for
+    void beginStage(const CalcStage);
+    CalcStage getStage() const;
+    void addWork(const uint64_t, const CalcStage);
+    void addWork(const uint64_t);
+    void addProgress(const uint64_t, const CalcStage);
+    void addProgress(const uint64_t=1);
+    uint64_t getWork(const CalcStage) const;
+    uint64_t getProgress(const CalcStage) const;
+    // fraction of the work of a stage that is done. stages without any work count as not started
+    double getFraction(const CalcStage) const;
+
+  private:
+    static constexpr size_t s_n_stages = size_t(CalcStage::count);
+
+    std::atomic<bool> _aborted;
+    std::atomic<unsigned char> _stage;
+    std::array<std::atomic<uint64_t>,s_n_stages> _work;
+    std::array<std::atomic<uint64_t>,s_n_stages> _done;
+};
+
+#endif
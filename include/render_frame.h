@@ -33,8 +33,7 @@ class wxScrollEvent;
 class wxButton;
 class wxListCtrl;
 
-template <typename> class Container3D;
-class Voxel;
+class Space;
 class MainFrame;
 struct Atom;
 
@@ -44,8 +43,8 @@ class RenderFrame : public wxFrame {
     ~RenderFrame();
 
     void OnClose(wxCloseEvent& event);
-    void UpdateSurface(const Container3D<Voxel>&, const std::array<double,3>, 
-        const double, const bool, const unsigned char);
+    void UpdateSurface(const Space&, const std::array<double,3>, 
+        const double, const bool, const size_t);
     void UpdateMolecule(const std::vector<Atom>&);
     void Render();
   
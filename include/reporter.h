@@ -0,0 +1,41 @@
+#ifndef REPORTER_H
+
+#define REPORTER_H
+
+#include "progress.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+// receives the messages of a calculation and holds the token that aborts it. the base class is used
+// for calculations without user interface: status updates are ignored and error messages are kept,
+// so that the caller can read them after the calculation. the controller of the application
+// overrides the messages to show them in the gui or on the command line
+class Reporter{
+  public:
+    virtual ~Reporter() = default;
+
+    virtual void notifyUser(std::string){}
+    virtual void notifyUser(std::wstring){}
+    virtual void updateStatus(std::string){}
+    virtual void updateProgressBar(const int){}
+    // gives a user interface the chance to request an abort. only called from the calculation thread
+    virtual void updateCalculationStatus(){}
+    virtual void displayErrorMessage(const int, const std::vector<std::string>& =std::vector<std::string>());
+
+    // error codes and messages received by the base class since the last call of clearErrors()
+    const std::vector<std::pair<int,std::string>>& getErrors() const {return _errors;}
+    void clearErrors(){_errors.clear();}
+
+    bool getAbortFlag() const {return _progress.isAborted();}
+    ProgressToken& getProgressToken(){return _progress;}
+
+    // message of an error code, with the place holders replaced by the strings in order
+    static std::string getErrorMessage(const int, const std::vector<std::string>& =std::vector<std::string>());
+
+  private:
+    ProgressToken _progress; // abort signal and progress of the running calculation, shared with the worker threads
+    std::vector<std::pair<int,std::string>> _errors;
+};
+
+#endif
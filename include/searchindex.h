@@ -0,0 +1,39 @@
+#ifndef SEARCHINDEX_H
+
+#define SEARCHINDEX_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <memory>
+
+// this struct is used to store the relative indices of neighbour voxels in increasing distance,
+// as well as the upper search distance limits for every level. shell n lists all relative
+// indices whose squares add up to n
+struct SearchIndex{
+  public:
+    typedef std::vector<std::vector<std::array<int,3>>> Shells;
+
+    SearchIndex();
+    SearchIndex(const double, const double, const unsigned int);
+    const std::vector<std::array<int,3>>& operator[](unsigned int);
+    unsigned int getUppLim(unsigned int);
+    unsigned int getSafeLim(unsigned int);
+    Shells computeIndices(unsigned int);
+    Shells computeIndices(unsigned int, const bool);
+
+    // the shells are shared by all search indices of the process and are only computed, if no earlier
+    // calculation needed as many shells. if a cache directory is set, computed shells are stored there
+    // and read back by later runs. an empty path disables the cache directory
+    static void setCacheDir(const std::string&);
+    static std::shared_ptr<const Shells> getShells(const unsigned int);
+    // cache file of shells 0 to upp_lim. reading fails, if the file does not exist or does not match
+    static bool readShells(const std::string&, const unsigned int, Shells&);
+    static bool writeShells(const std::string&, const Shells&);
+  private:
+    std::shared_ptr<const Shells> _index_list;
+    std::vector<unsigned> _upp_lim;
+    std::vector<unsigned> _safe_lim;
+};
+
+#endif
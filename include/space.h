@@ -5,9 +5,33 @@
 #include "voxel.h"
 #include "container3d.h"
 #include "cavity.h"
+#include "tiling.h"
+#include "sparsegrid.h"
+#include "reporter.h"
 #include <vector>
 #include <array>
 #include <map>
+#include <functional>
+#include <cstdint>
+
+// tables of the surface area of the marching cube configurations
+enum class AreaTable{semi_empirical, theoretical};
+
+// number of marching cubes per configuration. interior cubes count with weight one, cubes at the border
+// of the unit cell are grouped by their weight. the surface area is the dot product of the counts with
+// the areas of the configurations, so the counting is exact and the table can be chosen afterwards
+class SurfaceHistogram{
+  public:
+    void add(const unsigned char config){_interior[config]++;}
+    void add(const unsigned char, const double);
+    SurfaceHistogram& operator+=(const SurfaceHistogram&);
+    double area(const AreaTable=AreaTable::semi_empirical) const;
+  private:
+    std::array<uint64_t,256> _interior = {};
+    std::vector<std::pair<double,std::array<uint64_t,256>>> _border;
+
+    std::array<uint64_t,256>& getCounts(const double);
+};
 
 struct Atom;
 class Voxel;
@@ -15,7 +39,7 @@ class Space{
   public:
     // constructors
     Space() = default;
-    Space(std::vector<Atom>&, const double, const int, const double, const bool, const std::array<double,3>);
+    Space(std::vector<Atom>&, const double, const int, const double, const bool, const std::array<double,3>, const unsigned=1, const bool=false, const bool=false);
 
     // access
     std::array<double,3> getMin() const;
@@ -25,14 +49,28 @@ class Space{
     bool isInBounds(const std::array<int,3>&, const unsigned);
     bool isInBounds(const std::array<unsigned,3>&, const unsigned);
     double getVxlSize() const;
-    const Container3D<Voxel>& getGrid(const unsigned) const;
+    // constants of the voxels on one level, computed once per grid, so that the octree recursion
+    // does not need std::pow
+    struct LevelConstants{
+      double edge; // edge length of a voxel
+      double radius; // distance from the centre to the centres of the bottom level voxels in its corners
+      double n_bot_lvl_vxl; // number of bottom level voxels inside of a voxel
+      std::array<unsigned long,3> n_vxl; // number of voxels in each direction
+    };
+    const LevelConstants& getLevelConstants(const int lvl) const {return _lvl_constants[lvl];}
+    template <typename T = unsigned long>
+    const std::array<T,3> getGridstepsOnLvl(const int lvl) const {
+      std::array<T,3> steps;
+      for (char i = 0; i < 3; ++i){
+        steps[i] = static_cast<T>(_n_top_vxl[i] << (_max_depth-lvl));
+      }
+      return steps;
+    }
 
     // get voxel
-    Voxel& getVxlFromGrid(const unsigned int, unsigned);
     Voxel& getVxlFromGrid(const unsigned int, const unsigned int, const unsigned int, unsigned);
     Voxel& getVxlFromGrid(const std::array<unsigned int,3>, unsigned);
     Voxel& getVxlFromGrid(const std::array<int,3>, unsigned);
-    Voxel& getTopVxl(const unsigned int);
     Voxel& getTopVxl(const unsigned int, const unsigned int, const unsigned int);
     Voxel& getTopVxl(const std::array<unsigned int,3>);
     Voxel& getTopVxl(const std::array<int,3>);
@@ -40,7 +78,54 @@ class Space{
     std::array<std::array<unsigned int,3>,2> getUnitCellIndexes();
     unsigned long int totalVxlOnLvl(const int) const;
 
+    // read-only access to the type, works in both dense and sparse mode
+    template<std::integral INT>
+    char getType(const std::array<INT,3>& index, const unsigned lvl) const {
+      if (_sparse){return _sparse_grid.getVoxel(index, lvl).getType();}
+      return _grid[lvl].getElement(index).getType();
+    }
+
+    // cavity ids
+    template<std::integral INT>
+    Cavity::id_type getID(const std::array<INT,3>& index, const unsigned lvl) const {
+      if (_sparse){return _sparse_grid.getID(index, lvl);}
+      return _wide_ids.empty()? _ids[lvl].getElement(index) : _wide_ids[lvl].getElement(index);
+    }
+    template<std::integral INT>
+    void setID(const std::array<INT,3>& index, const unsigned lvl, const Cavity::id_type id){
+      if (_sparse){_sparse_grid.getID(index, lvl) = id;}
+      else if (_wide_ids.empty()){_ids[lvl].getElement(index) = id;}
+      else {_wide_ids[lvl].getElement(index) = id;}
+    }
+    bool hasWideIDs() const {return !_wide_ids.empty();}
+    void enableWideIDs();
+
+    // raw planes of one level for passes that stream through the grid. the type plane holds one
+    // byte per voxel. the id plane is either the narrow or the wide plane, the other one is a nullptr.
+    // planes only exist in dense mode. they are stored in Morton order (see MortonLayout), so the parent
+    // of the voxel at position i is at position i/8 on the next higher level
+    const Voxel* getTypePlane(const unsigned lvl) const {return _sparse? nullptr : _grid[lvl].data();}
+    const unsigned char* getIDPlane(const unsigned lvl) const {return _ids.empty()? nullptr : _ids[lvl].data();}
+    const Cavity::id_type* getWideIDPlane(const unsigned lvl) const {return _wide_ids.empty()? nullptr : _wide_ids[lvl].data();}
+    std::array<unsigned long,3> getPlaneCoord(const unsigned lvl, const unsigned long pos) const {return _grid[lvl].getCoord(pos);}
+    // copies the types and ids of the voxels from x_begin to x_end (exclusive) in row y,z of a level into
+    // arrays indexed by x. ids are skipped if the id array is a nullptr. works in both dense and sparse mode
+    void readRow(const int, const unsigned, const unsigned, const unsigned, const unsigned, Voxel*, Cavity::id_type*) const;
+
+    // sparse mode: subvoxels are only allocated for mixed voxels (see SparseGrid)
+    bool isSparse() const {return _sparse;}
+    void allocateSubvoxels(const std::array<unsigned,3>&, const int, const char);
+
+    // pass the type or id of a pure voxel to all of its descendants
+    void fillSubtreeType(const std::array<unsigned,3>&, const int, const char);
+    void fillSubtreeID(const std::array<unsigned,3>&, const int, const Cavity::id_type);
+
     int getMaxDepth(){return _max_depth;}
+    unsigned getNumThreads() const {return _n_threads;}
+    // the calculation reports its status to the reporter, its progress to the token of the reporter
+    // and stops once the token is aborted
+    void setReporter(Reporter&);
+    ProgressToken& getProgressToken() const {return *_progress;}
     // output
     void printGrid();
 
@@ -50,13 +135,32 @@ class Space{
     void setUnitCellIndexes();
 
     // surface area
-    double calcSurfArea(const std::vector<char>&);
-    double calcSurfArea(const std::vector<char>&, const unsigned char, std::array<unsigned int,3>, std::array<unsigned int,3>);
+    // surfaces of several sets of solid types and of the shell and core of every cavity, counted in a
+    // single sweep over the bottom level. the areas are in squared length units
+    struct SurfaceSums{
+      std::vector<SurfaceHistogram> total; // one per set of solid types
+      std::map<Cavity::id_type,std::array<SurfaceHistogram,2>> cavities; // shell and core
+      double face_area = 0; // squared grid step
+
+      double totalArea(const unsigned, const AreaTable=AreaTable::semi_empirical) const;
+      double cavityShellArea(const Cavity::id_type, const AreaTable=AreaTable::semi_empirical) const;
+      double cavityCoreArea(const Cavity::id_type, const AreaTable=AreaTable::semi_empirical) const;
+    };
+    SurfaceSums calcSurfAreas(const std::vector<std::vector<char>>&, const std::vector<char>&, const std::vector<char>&);
 
   private:
     std::array <double,3> _cart_min; // this is also the "origin" of the space
     std::array <double,3> _cart_max;
-    std::vector<Container3D<Voxel>> _grid;
+    std::array<unsigned long,3> _n_top_vxl;
+    // one plane per level. each top level voxel is a block in which the voxels of all lower
+    // levels are stored in Morton order, so that the subvoxels of a voxel are next to each other
+    template <class T>
+    using Plane = Container3D<T, MortonLayout>;
+    std::vector<Plane<Voxel>> _grid;
+    // cavity ids, one plane per level like _grid
+    std::vector<Plane<unsigned char>> _ids;
+    // replaces _ids once there are more than 255 cavities
+    std::vector<Plane<Cavity::id_type>> _wide_ids;
     // bottom level voxels indexes for the start of the unit cell in x,y,z direction
     std::array<unsigned int,3> _unit_cell_start_index; 
     // bottom level voxels indexes for the end of the unit cell in x,y,z direction
@@ -65,25 +169,39 @@ class Space{
     std::array<double,3> _unit_cell_mod_index; 
     double _grid_size;
     int _max_depth; // for voxels
+    std::vector<LevelConstants> _lvl_constants; // one entry per level
     std::array<double,3> _unit_cell_limits; // cartesian coordinates of the unit cell orthogonal axes
     bool _unit_cell; // option to analyze unit cell
+    unsigned _n_threads = 1; // number of worker threads for the type assignment, 0 for all cores
+    bool _sparse = false; // replaces _grid and the id planes with _sparse_grid
+    bool _distance_transform = false; // shell vs void skips empty neighbour shells using CoreDistances
+    // spaces without a reporter of their own share this one
+    static inline Reporter s_default_reporter;
+    Reporter* _reporter = &s_default_reporter;
+    ProgressToken* _progress = &s_default_reporter.getProgressToken();
+    SparseGrid _sparse_grid;
 
     void setBoundaries(const std::vector<Atom>&, const double);
 
     void initGrid();
-    
-    template <typename T = unsigned long>
-    const std::array<T,3> getGridstepsOnLvl(const int lvl) const {
-      return _grid[lvl].getNumElements<T>();
-    }
 
     void assignAtomVsCore();
+    void assignAtomVsCoreParallel();
     void identifyCavities(std::vector<Cavity>&, const bool=false);
-    void descendToCore(std::vector<Cavity>&, unsigned char&, const std::array<unsigned,3>, int, const bool);
+    void identifyCavitiesParallel(std::vector<Cavity>&, const bool);
+    void descendToCore(std::vector<Cavity>&, Cavity::id_type&, const std::array<unsigned,3>, int, const bool);
     void assignShellVsVoid();
-
-    double tallySurface(const std::vector<char>&, std::array<unsigned int,3>&, std::array<unsigned int,3>&, const unsigned char=0, const bool=false);
-    unsigned char evalMarchingCubeConfig(const std::array<unsigned int,3>&, const std::vector<char>&, const unsigned char, const bool);
+    void assignShellVsVoidSerial();
+    void assignShellVsVoidParallel();
+    CoreSnapshot snapshotCoreBits();
+    void forEachTopVxlParallel(const std::function<void(const std::array<unsigned,3>&)>&);
+    void runTilesInParallel(TileScheduler&, const std::function<void(const TileScheduler::Tile&)>&);
+    static size_t numSlabs(const unsigned long);
+    void forEachSlab(const unsigned long, const std::function<void(const size_t, const unsigned long, const unsigned long)>&);
+
+    unsigned char evalMarchingCubeConfig(const std::array<unsigned int,3>&, const std::array<bool,256>&, const Cavity::id_type, const bool);
+    template <typename CubeFunc>
+    void forEachUnitCellBorderCube(const CubeFunc&);
 
 };
 
@@ -91,10 +209,11 @@ class SurfaceLUT {
   private:
     static const std::array<unsigned char,256> types_by_config;
     static const std::array<double, 15> area_by_type;
+    static const std::array<double, 15> theoretical_area_by_type;
   public:
     static unsigned char configToType(unsigned char config);
-    static double typeToArea(unsigned char type);
-    static double configToArea(unsigned char config);
+    static double typeToArea(unsigned char type, const AreaTable=AreaTable::semi_empirical);
+    static double configToArea(unsigned char config, const AreaTable=AreaTable::semi_empirical);
 };
 
 #endif
@@ -0,0 +1,127 @@
+#ifndef SPARSEGRID_H
+
+#define SPARSEGRID_H
+
+#include "voxel.h"
+#include "container3d.h"
+#include "cavity.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <limits>
+
+// octree storage that only allocates the subvoxels of mixed voxels. the top level is stored densely.
+// below the top level, the eight subvoxels of a mixed voxel form a brick, which is allocated from a pool
+// when the voxel is split. a pure voxel has no subvoxels. all of its descendants have its type and id,
+// so when a voxel inside of a pure voxel is requested, the pure voxel is returned instead
+class SparseGrid{
+  public:
+    SparseGrid() = default;
+    SparseGrid(const std::array<unsigned long,3>& n_top_vxl, const int max_depth);
+
+    template<std::integral INT>
+    Voxel& getVoxel(const std::array<INT,3>& index, const int lvl){
+      return getVoxel(findSlot(index, lvl));
+    }
+    template<std::integral INT>
+    const Voxel& getVoxel(const std::array<INT,3>& index, const int lvl) const {
+      return getVoxel(findSlot(index, lvl));
+    }
+    template<std::integral INT>
+    Cavity::id_type& getID(const std::array<INT,3>& index, const int lvl){
+      return getID(findSlot(index, lvl));
+    }
+    template<std::integral INT>
+    const Cavity::id_type& getID(const std::array<INT,3>& index, const int lvl) const {
+      return getID(findSlot(index, lvl));
+    }
+
+    // allocates the subvoxels of a voxel that is split. the subvoxels start off with the given type
+    // and the id of the voxel. does nothing, if the subvoxels already exist. thread safe, as long as
+    // no two threads split the same voxel
+    void allocateSubvoxels(const std::array<unsigned,3>&, const int, const char);
+    // copies the types and ids of the voxels from x_begin to x_end (exclusive) in row y,z of a level.
+    // the output arrays are indexed by x. ids are skipped if the id array is a nullptr
+    void readRow(const int, const unsigned, const unsigned, const unsigned, const unsigned, Voxel*, Cavity::id_type*) const;
+    // number of voxels allocated below the top level
+    size_t getNumAllocated() const;
+
+  private:
+    static constexpr uint32_t s_no_subvoxels = std::numeric_limits<uint32_t>::max();
+
+    // location of a voxel. pos is the linear index on the top level and brick*8 + subvoxel below
+    struct Slot{
+      int lvl;
+      uint64_t pos;
+    };
+
+    // voxels of one level below the top level. bricks are stored in chunks that are never moved,
+    // so that references to voxels remain valid while other threads allocate further bricks
+    class Pool{
+      public:
+        Pool(const uint64_t max_vxl);
+        uint32_t allocateBrick();
+        size_t size() const;
+        Voxel& getVoxel(const uint64_t pos){return _chunks[pos >> s_chunk_bits]->types[pos & s_chunk_mask];}
+        Cavity::id_type& getID(const uint64_t pos){return _chunks[pos >> s_chunk_bits]->ids[pos & s_chunk_mask];}
+        uint32_t& getSubvoxels(const uint64_t pos){return _chunks[pos >> s_chunk_bits]->subvoxels[pos & s_chunk_mask];}
+      private:
+        static constexpr unsigned s_chunk_bits = 16;
+        static constexpr uint64_t s_chunk_mask = (uint64_t(1) << s_chunk_bits) - 1;
+        struct Chunk{
+          std::array<Voxel, 1 << s_chunk_bits> types;
+          std::array<Cavity::id_type, 1 << s_chunk_bits> ids;
+          std::array<uint32_t, 1 << s_chunk_bits> subvoxels;
+        };
+        std::vector<std::unique_ptr<Chunk>> _chunks; // sized for the dense level, filled on demand
+        uint64_t _n_bricks = 0;
+        mutable std::mutex _mtx;
+    };
+
+    std::array<unsigned long,3> _n_top_vxl;
+    int _max_depth;
+    Container3D<Voxel> _top_types;
+    Container3D<Cavity::id_type> _top_ids;
+    Container3D<uint32_t> _top_subvoxels;
+    std::vector<std::unique_ptr<Pool>> _pools; // one per level below the top level
+
+    Voxel& getVoxel(const Slot& slot){
+      return slot.lvl == _max_depth? _top_types.getElement(slot.pos) : _pools[slot.lvl]->getVoxel(slot.pos);
+    }
+    const Voxel& getVoxel(const Slot& slot) const {
+      return const_cast<SparseGrid*>(this)->getVoxel(slot);
+    }
+    Cavity::id_type& getID(const Slot& slot){
+      return slot.lvl == _max_depth? _top_ids.getElement(slot.pos) : _pools[slot.lvl]->getID(slot.pos);
+    }
+    const Cavity::id_type& getID(const Slot& slot) const {
+      return const_cast<SparseGrid*>(this)->getID(slot);
+    }
+    uint32_t& getSubvoxels(const Slot& slot){
+      return slot.lvl == _max_depth? _top_subvoxels.getElement(slot.pos) : _pools[slot.lvl]->getSubvoxels(slot.pos);
+    }
+    uint32_t getSubvoxels(const Slot& slot) const {
+      return const_cast<SparseGrid*>(this)->getSubvoxels(slot);
+    }
+
+    // descends from the top level voxel towards the requested voxel until a voxel without subvoxels is reached
+    template<std::integral INT>
+    Slot findSlot(const std::array<INT,3>& index, const int lvl) const {
+      const int n_sublvl = _max_depth - lvl;
+      Slot slot = {_max_depth,
+        ((uint64_t)(index[2] >> n_sublvl) * _n_top_vxl[1] + (index[1] >> n_sublvl)) * _n_top_vxl[0] + (index[0] >> n_sublvl)};
+      while (slot.lvl > lvl){
+        const uint32_t brick = getSubvoxels(slot);
+        if (brick == s_no_subvoxels){break;}
+        slot.lvl--;
+        const int shift = slot.lvl - lvl;
+        slot.pos = uint64_t(brick) * 8
+          + ((index[0] >> shift) & 1) + (((index[1] >> shift) & 1) << 1) + (((index[2] >> shift) & 1) << 2);
+      }
+      return slot;
+    }
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TILING_H
+
+#define TILING_H
+
+#include <array>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+// splits a 3d index space into bricks (tiles) and distributes the tiles among a number of
+// worker threads. every worker starts off with its own queue of neighbouring tiles. once a
+// worker's queue has run dry it steals tiles from the back of the other queues. this keeps
+// all workers busy even when some tiles are much more expensive than others, e.g. tiles at
+// the molecule surface compared to tiles in empty space
+class TileScheduler{
+  public:
+    typedef std::array<unsigned,3> index_type;
+    struct Tile{
+      index_type start; // first index inside tile
+      index_type end; // first index outside tile
+    };
+
+    TileScheduler(const index_type&, const unsigned tile_edge, const unsigned n_threads);
+    TileScheduler(const index_type&, const index_type& tile_size, const unsigned n_threads);
+
+    size_t size() const;
+    unsigned getNumThreads() const;
+    const Tile& getTile(const size_t) const;
+
+    // calls the work function once for every tile. the calling thread participates as
+    // worker 0 and is the only thread that calls the (optional) progress function. the
+    // progress function receives the fraction of finished tiles and returns false, if the
+    // remaining tiles should be skipped
+    void run(const std::function<void(const Tile&, const unsigned)>&,
+        const std::function<bool(const double)>& = nullptr);
+    void stop();
+    bool isStopped() const;
+
+    // resolves the user input for the number of threads. 0 means all available cores
+    static unsigned resolveNumThreads(const unsigned);
+
+  private:
+    struct WorkQueue{
+      std::deque<size_t> tiles;
+      std::mutex mtx;
+    };
+
+    std::vector<Tile> _tiles;
+    unsigned _n_threads;
+    std::atomic<bool> _stop;
+    std::atomic<size_t> _n_done;
+
+    bool popTile(std::vector<WorkQueue>&, const unsigned, size_t&);
+};
+
+#endif
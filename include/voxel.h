@@ -4,33 +4,69 @@
 
 #include "vector.h"
 #include "atomtree.h"
+#include "atomclassify.h"
+#include "searchindex.h"
 #include "container3d.h"
 #include "flags.h"
 #include "cavity.h"
+#include "progress.h"
 #include <vector>
 #include <array>
 #include <unordered_map>
 #include <map>
+#include <cstdint>
+
+struct VoxelLoc{
+  VoxelLoc() = default;
+  VoxelLoc(const std::array<unsigned,3>& index, const int lvl) : index(index), lvl(lvl), interface_vxl(false) {}
+  VoxelLoc(const std::array<unsigned,3>& index, const int lvl, const bool interface_vxl)
+    : index(index), lvl(lvl), interface_vxl(interface_vxl) {}
+  std::array<unsigned,3> index;
+  int lvl;
+  bool interface_vxl;
+};
+
+// read-only copy of what the shell vs void evaluation needs to know about the neighbours of a voxel:
+// whether they contain a probe core and whether they are pure small probe core voxels. the copy takes
+// two bits per voxel and is used while several threads evaluate voxels concurrently, or while the grid
+// is sparse and looking up neighbours in the octree would be slow
+class CoreSnapshot{
+  public:
+    CoreSnapshot(const std::vector<std::array<unsigned long,3>>&, const unsigned char core_bit);
+    void setType(const unsigned lvl, const unsigned long i, const char type);
+    // returns a type that has the same core bit as the voxel's type and is only pure core if the voxel is
+    template<std::integral INT>
+    char getType(const std::array<INT,3>& coord, const unsigned lvl) const {
+      const unsigned long i = (coord[2] * _n_vxl[lvl][1] + coord[1]) * _n_vxl[lvl][0] + coord[0];
+      return _types[(_bits[lvl][i >> 5] >> ((i & 31) * 2)) & 3];
+    }
+    // whether the voxel at position i of a level in row major order contains a probe core
+    bool hasCore(const unsigned lvl, const unsigned long i) const {return (_bits[lvl][i >> 5] >> ((i & 31) * 2)) & 3;}
+    const std::vector<std::array<unsigned long,3>>& getGridsteps() const {return _n_vxl;}
+  private:
+    std::vector<std::array<unsigned long,3>> _n_vxl;
+    std::vector<std::vector<uint64_t>> _bits;
+    unsigned char _core_bit;
+    std::array<char,3> _types; // type returned for each state: no core, contains core, pure core
+};
 
-struct SearchIndex{
+// squared distance of every voxel to the closest voxel on the same level that contains a probe core,
+// in units of the voxel edge length. the neighbour search uses it to skip the shells that contain
+// no core. the distances are exact, so the search still stops at the same neighbour as before
+class CoreDistances{
   public:
-    SearchIndex();
-    SearchIndex(const double, const double, const unsigned int);
-    const std::vector<std::array<int,3>>& operator[](unsigned int);
-    unsigned int getUppLim(unsigned int);
-    unsigned int getSafeLim(unsigned int);
-    std::vector<std::vector<std::array<int,3>>> computeIndices(unsigned int);
-    std::vector<std::vector<std::array<int,3>>> computeIndices(unsigned int, const bool);
+    CoreDistances(const CoreSnapshot&);
+    // first shell that may contain a core, but at least n_first. shells are only skipped if all of
+    // their neighbours are inside of the grid, so neighbours outside of the grid are read as before
+    unsigned firstShell(const std::array<unsigned,3>&, const unsigned lvl, const unsigned n_first) const;
   private:
-    std::vector<std::vector<std::array<int,3>>> _index_list;
-    std::vector<unsigned> _upp_lim;
-    std::vector<unsigned> _safe_lim;
+    std::vector<std::array<unsigned long,3>> _n_vxl;
+    std::vector<std::vector<uint16_t>> _sq_dist;
 };
 
 class Space;
 class FloodStack;
 struct Atom;
-struct VoxelLoc;
 class Voxel{
   public:
     Voxel();
@@ -40,8 +76,6 @@ class Voxel{
     Voxel& getSubvoxel(std::array<unsigned,3>, const unsigned);
     void setType(char);
     char getType() const;
-    void setID(unsigned char);
-    unsigned char getID() const;
 
     // bitwise operations on _type
     bool hasSubvoxel(); // state of bit 7
@@ -55,50 +89,53 @@ class Voxel{
     static void computeIndices(unsigned int);
 
     // atom vs probe core
-    char evalRelationToAtoms(const std::array<unsigned,3>&, Vector, const int);
-    void traverseTree(const AtomNode*, const double, const Vector&, const double, const double, const int,
-        const char = 0b00000011, const char = 0);
+    char evalRelationToAtoms(const std::array<unsigned,3>&, Vector, const int, const AtomBlock* = nullptr);
+    void traverseTree(AtomBlock&, const AtomTree::Range&, const Vector&, const double);
     void passTypeToChildren(const std::array<unsigned,3>&, const int);
-    void splitVoxel(const std::array<unsigned,3>&, const Vector&, const double);
+    void splitVoxel(const std::array<unsigned,3>&, const Vector&, const int, const AtomBlock&);
 
     // cavity id
-    bool floodFill(std::vector<Cavity>&, const unsigned char, const std::array<unsigned,3>&, const int, const bool=false);
+    bool floodFill(std::vector<Cavity>&, const Cavity::id_type, const std::array<unsigned,3>&, const int, const bool=false);
+    std::vector<VoxelLoc> findCoreNeighbours(const VoxelLoc&);
+    void passIDtoChildren(const std::array<unsigned,3>&, const int);
 
     // shell vs void
     char evalRelationToVoxels(const std::array<unsigned int,3>&, const unsigned, bool=false);
+    static void setCoreSnapshot(const CoreSnapshot*);
+    static void setCoreDistances(const CoreDistances*);
+    static unsigned char getCoreBit(); // type bit of the probe core that is searched for
 
     // volume
     void tallyVoxelsOfType(std::map<char,double>&,
-        std::map<unsigned char,double>&,
-        std::map<unsigned char,double>&,
-        std::map<unsigned char,std::array<unsigned,3>>&,
-        std::map<unsigned char,std::array<unsigned,3>>&,
+        std::map<Cavity::id_type,double>&,
+        std::map<Cavity::id_type,double>&,
+        std::map<Cavity::id_type,std::array<unsigned,3>>&,
+        std::map<Cavity::id_type,std::array<unsigned,3>>&,
         const std::array<unsigned,3>&,
         const int,
         const double=1);
 
-    // unused but could become useful
-    static void listFromTree(std::vector<int>&, const AtomNode*, const Vector&, 
-        const double&, const double&, const double&, const char=0);
     static const AtomTree& getAtomTree() {
       return *s_atomtree;
     }
   private:
+    // the voxel only holds its type, so that each level of the grid is a contiguous plane of
+    // types. cavity ids are stored in separate planes by Space
     char _type;
-    unsigned char _identity;
 
     static inline Space* s_cell; // gets destroyed by Model
+    static inline const ProgressToken* s_progress; // token of s_cell, sampled for aborts in the recursions
     // atom vs core
     static inline AtomTree* s_atomtree;
     // shell vs void
     static inline double s_r_probe;
     static inline bool s_masking_mode;
     static inline SearchIndex s_search_indices;
+    // neighbour types are read from this copy while it is set
+    static inline const CoreSnapshot* s_core_snapshot = nullptr;
+    // shells closer than the closest core are skipped while this is set
+    static inline const CoreDistances* s_core_distances = nullptr;
 
-    static inline double calcVxlRadius(const double& max_depth);
-
-    // atom vs core
-    bool isAtom(const Atom&, const Vector&, const double, const double);
     // cavity id
     bool isInterfaceVxl(const VoxelLoc&);
     std::vector<VoxelLoc> findPureNeighbours(const VoxelLoc&, const unsigned char=mvTYPE_ALL, const bool=false);
@@ -107,7 +144,6 @@ class Voxel{
         const int, const std::array<int,3>&, const unsigned char);
     void ascend(std::vector<VoxelLoc>&, const std::array<unsigned,3>, 
         const int, std::array<unsigned,3>, const std::array<int,3>&);
-    void passIDtoChildren(const std::array<unsigned,3>&, const int);
     // shell vs void
     bool searchForCore(const std::array<unsigned int,3>&, const unsigned, bool=false);
 };
@@ -0,0 +1,246 @@
+#include "atomclassify.h"
+#include "misc.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MOLOVOL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+////////////////
+// ATOM BLOCK //
+////////////////
+
+void AtomBlock::clear(){
+  for (char dim = 0; dim < 3; dim++){
+    pos[dim].clear();
+  }
+  rad.clear();
+}
+
+void AtomBlock::push_back(const Vector& atom_pos, const double atom_rad){
+  for (char dim = 0; dim < 3; dim++){
+    pos[dim].push_back(atom_pos[dim]);
+  }
+  rad.push_back(atom_rad);
+}
+
+void filterAtoms(AtomBlock& close_atoms, const AtomBlock& candidates, const Vector& pos, const double reach){
+  for (size_t i = 0; i < candidates.size(); i++){
+    double dist = 0;
+    for (char dim = 0; dim < 3; dim++){
+      const double diff = pos[dim] - candidates.pos[dim][i];
+      dist += diff * diff;
+    }
+    const double reach_atom = candidates.rad[i] + reach;
+    if (dist < reach_atom * reach_atom){
+      close_atoms.push_back(Vector(candidates.pos[0][i], candidates.pos[1][i], candidates.pos[2][i]), candidates.rad[i]);
+    }
+  }
+}
+
+//////////////
+// CONTACTS //
+//////////////
+
+// every atom is in at most one of the following relations to a voxel:
+// inside: the voxel is completely inside of the atom
+// partial: the voxel is partially inside of the atom
+// shell: the voxel is outside of the atom, but too close for a probe core
+// touching: the voxel is partially in reach of a probe core touching the atom
+struct Contacts{
+  bool inside = false;
+  bool partial = false;
+  bool shell = false;
+  bool touching = false;
+  bool last_is_shell = false; // relation of the last atom that is either shell or touching
+};
+
+// applies the relations in the same way as evaluating the atoms one by one. a voxel inside of an atom
+// is final. partially inside overrides both shell types. a touching atom does not change a type with
+// bit 4 set. in masking mode the shell type does not have bit 4, so after the first shell atom the
+// last atom decides
+char mergeContacts(const Contacts& contacts, const char type, const bool masking_mode){
+  const char shell_type = masking_mode? 0b01000000 : 0b00010000;
+  const char touching_type = masking_mode? 0b11000000 : 0b10010000;
+  if (contacts.inside){return 0b00000011;}
+  if (readBit(type,1)){return type;}
+  if (contacts.partial){return 0b10000010;}
+  if (!contacts.shell && !contacts.touching){return type;}
+  if (masking_mode){
+    if (readBit(type,4) && !contacts.shell){return type;}
+    return contacts.last_is_shell? shell_type : touching_type;
+  }
+  if (contacts.shell){return shell_type;}
+  return readBit(type,4)? type : touching_type;
+}
+
+////////////
+// SCALAR //
+////////////
+
+void classifyScalar(const AtomBlock& block, const size_t first, const Vector& pos_vxl, const double rad_vxl,
+    const double rad_probe, Contacts& contacts){
+  for (size_t i = first; i < block.size(); i++){
+    double dist = 0;
+    for (char dim = 0; dim < 3; dim++){
+      const double diff = pos_vxl[dim] - block.pos[dim][i];
+      dist += diff * diff;
+    }
+    const double rad = block.rad[i];
+    const double inside = rad - rad_vxl;
+    const double partial = rad + rad_vxl;
+    const double shell = rad + rad_probe - rad_vxl;
+    const double touching = rad + rad_probe + rad_vxl;
+    if (dist < inside * inside && 0 < inside){ // if completely inside atom
+      contacts.inside = true;
+      return;
+    }
+    else if (dist < partial * partial){ // if partially inside atom
+      contacts.partial = true;
+    }
+    else if (dist < shell * shell && 0 < shell){ // if outside atom but not touching potential probe core
+      contacts.shell = true;
+      contacts.last_is_shell = true;
+    }
+    else if (dist < touching * touching){ // if outside atom but touching potential probe core
+      contacts.touching = true;
+      contacts.last_is_shell = false;
+    }
+  }
+}
+
+//////////
+// SIMD //
+//////////
+
+#ifdef MOLOVOL_X86_KERNELS
+
+// updates the contacts with the relation masks of a group of atoms. bit i of each mask belongs to atom i
+inline void addMasks(Contacts& contacts, const unsigned inside, const unsigned partial, const unsigned shell, const unsigned touching){
+  contacts.inside |= inside != 0;
+  contacts.partial |= partial != 0;
+  contacts.shell |= shell != 0;
+  contacts.touching |= touching != 0;
+  const unsigned shell_or_touching = shell | touching;
+  if (shell_or_touching){
+    const int last = 31 - __builtin_clz(shell_or_touching);
+    contacts.last_is_shell = (shell >> last) & 1;
+  }
+}
+
+// the kernels only use multiplications and additions, which are not fused, so every lane gives
+// exactly the same result as the scalar kernel
+__attribute__((target("avx2")))
+size_t classifyAVX2(const AtomBlock& block, const Vector& pos_vxl, const double rad_vxl, const double rad_probe, Contacts& contacts){
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d v_rad_vxl = _mm256_set1_pd(rad_vxl);
+  const __m256d v_rad_probe = _mm256_set1_pd(rad_probe);
+  __m256d v_pos_vxl[3];
+  for (int dim = 0; dim < 3; dim++){
+    v_pos_vxl[dim] = _mm256_set1_pd(pos_vxl[dim]);
+  }
+  size_t i = 0;
+  for (; i + 4 <= block.size(); i += 4){
+    __m256d dist = zero;
+    for (int dim = 0; dim < 3; dim++){
+      const __m256d diff = _mm256_sub_pd(v_pos_vxl[dim], _mm256_loadu_pd(block.pos[dim].data() + i));
+      dist = _mm256_add_pd(dist, _mm256_mul_pd(diff, diff));
+    }
+    const __m256d rad = _mm256_loadu_pd(block.rad.data() + i);
+    const __m256d inside = _mm256_sub_pd(rad, v_rad_vxl);
+    const __m256d partial = _mm256_add_pd(rad, v_rad_vxl);
+    const __m256d shell = _mm256_sub_pd(_mm256_add_pd(rad, v_rad_probe), v_rad_vxl);
+    const __m256d touching = _mm256_add_pd(_mm256_add_pd(rad, v_rad_probe), v_rad_vxl);
+
+    const unsigned in_inside = _mm256_movemask_pd(_mm256_and_pd(
+          _mm256_cmp_pd(dist, _mm256_mul_pd(inside, inside), _CMP_LT_OQ), _mm256_cmp_pd(zero, inside, _CMP_LT_OQ)));
+    const unsigned in_partial = _mm256_movemask_pd(_mm256_cmp_pd(dist, _mm256_mul_pd(partial, partial), _CMP_LT_OQ));
+    const unsigned in_shell = _mm256_movemask_pd(_mm256_and_pd(
+          _mm256_cmp_pd(dist, _mm256_mul_pd(shell, shell), _CMP_LT_OQ), _mm256_cmp_pd(zero, shell, _CMP_LT_OQ)));
+    const unsigned in_touching = _mm256_movemask_pd(_mm256_cmp_pd(dist, _mm256_mul_pd(touching, touching), _CMP_LT_OQ));
+    // each atom only counts for the first relation that applies
+    const unsigned is_partial = in_partial & ~in_inside;
+    const unsigned is_shell = in_shell & ~in_inside & ~in_partial;
+    const unsigned is_touching = in_touching & ~in_inside & ~in_partial & ~in_shell;
+    addMasks(contacts, in_inside, is_partial, is_shell, is_touching);
+    if (contacts.inside){return block.size();}
+  }
+  return i;
+}
+
+__attribute__((target("avx512f")))
+size_t classifyAVX512(const AtomBlock& block, const Vector& pos_vxl, const double rad_vxl, const double rad_probe, Contacts& contacts){
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d v_rad_vxl = _mm512_set1_pd(rad_vxl);
+  const __m512d v_rad_probe = _mm512_set1_pd(rad_probe);
+  __m512d v_pos_vxl[3];
+  for (int dim = 0; dim < 3; dim++){
+    v_pos_vxl[dim] = _mm512_set1_pd(pos_vxl[dim]);
+  }
+  size_t i = 0;
+  for (; i + 8 <= block.size(); i += 8){
+    __m512d dist = zero;
+    for (int dim = 0; dim < 3; dim++){
+      const __m512d diff = _mm512_sub_pd(v_pos_vxl[dim], _mm512_loadu_pd(block.pos[dim].data() + i));
+      dist = _mm512_add_pd(dist, _mm512_mul_pd(diff, diff));
+    }
+    const __m512d rad = _mm512_loadu_pd(block.rad.data() + i);
+    const __m512d inside = _mm512_sub_pd(rad, v_rad_vxl);
+    const __m512d partial = _mm512_add_pd(rad, v_rad_vxl);
+    const __m512d shell = _mm512_sub_pd(_mm512_add_pd(rad, v_rad_probe), v_rad_vxl);
+    const __m512d touching = _mm512_add_pd(_mm512_add_pd(rad, v_rad_probe), v_rad_vxl);
+
+    const unsigned in_inside = _mm512_cmp_pd_mask(dist, _mm512_mul_pd(inside, inside), _CMP_LT_OQ)
+      & _mm512_cmp_pd_mask(zero, inside, _CMP_LT_OQ);
+    const unsigned in_partial = _mm512_cmp_pd_mask(dist, _mm512_mul_pd(partial, partial), _CMP_LT_OQ);
+    const unsigned in_shell = _mm512_cmp_pd_mask(dist, _mm512_mul_pd(shell, shell), _CMP_LT_OQ)
+      & _mm512_cmp_pd_mask(zero, shell, _CMP_LT_OQ);
+    const unsigned in_touching = _mm512_cmp_pd_mask(dist, _mm512_mul_pd(touching, touching), _CMP_LT_OQ);
+    const unsigned is_partial = in_partial & ~in_inside;
+    const unsigned is_shell = in_shell & ~in_inside & ~in_partial;
+    const unsigned is_touching = in_touching & ~in_inside & ~in_partial & ~in_shell;
+    addMasks(contacts, in_inside, is_partial, is_shell, is_touching);
+    if (contacts.inside){return block.size();}
+  }
+  return i;
+}
+
+#endif
+
+//////////////
+// DISPATCH //
+//////////////
+
+bool isKernelSupported(const AtomKernel kernel){
+  switch (kernel){
+    case AtomKernel::scalar:
+      return true;
+#ifdef MOLOVOL_X86_KERNELS
+    case AtomKernel::avx2:
+      return __builtin_cpu_supports("avx2");
+    case AtomKernel::avx512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+AtomKernel bestAtomKernel(){
+  static const AtomKernel best = isKernelSupported(AtomKernel::avx512)? AtomKernel::avx512
+    : isKernelSupported(AtomKernel::avx2)? AtomKernel::avx2 : AtomKernel::scalar;
+  return best;
+}
+
+char classifyAtoms(const AtomBlock& block, const Vector& pos_vxl, const double rad_vxl, const double rad_probe,
+    const char type, const bool masking_mode, const AtomKernel kernel){
+  Contacts contacts;
+  size_t first = 0;
+#ifdef MOLOVOL_X86_KERNELS
+  if (kernel == AtomKernel::avx512){first = classifyAVX512(block, pos_vxl, rad_vxl, rad_probe, contacts);}
+  else if (kernel == AtomKernel::avx2){first = classifyAVX2(block, pos_vxl, rad_vxl, rad_probe, contacts);}
+#endif
+  // remaining atoms that do not fill a whole simd register
+  if (!contacts.inside){classifyScalar(block, first, pos_vxl, rad_vxl, rad_probe, contacts);}
+  return mergeContacts(contacts, type, masking_mode);
+}
@@ -2,6 +2,8 @@
 #include "atomtree.h"
 #include "misc.h"
 #include <cmath>
+#include <algorithm>
+#include <numeric>
 
 ///////////////////
 // AUX FUNCTIONS //
@@ -9,67 +11,6 @@
 
 double findMaxRad(std::vector<Atom>& list_of_atoms);
 
-//////////////
-// ATOMNODE //
-//////////////
-
-// CONSTRUCTOR
-
-AtomNode::AtomNode(AtomTree* tree, size_t atom_id, AtomNode* left_node, AtomNode* right_node) 
-  : _parent_tree(tree), _left_child(left_node), _right_child(right_node), _atom_id(atom_id) {}
-
-// DESTRUCTOR
-
-AtomNode::~AtomNode(){
-  delete _left_child;
-  delete _right_child;
-}
-
-// ACCESS
-
-const AtomNode* AtomNode::getLeftChild() const {
-  return _left_child;
-}
-
-const AtomNode* AtomNode::getRightChild() const {
-  return _right_child;
-}
-
-AtomNode* AtomNode::getLeftChild(){
-  return _left_child;
-}
-
-AtomNode* AtomNode::getRightChild(){
-  return _right_child;
-}
-
-Atom& AtomNode::getAtom() const {
-  return _parent_tree->getAtomList()[_atom_id];
-}
-
-size_t AtomNode::getAtomId() const {
-  return _atom_id;
-}
-
-// OTHER
-void AtomNode::print(){
-  std::cout << getAtom().symbol << "("
-    << getAtom().getCoordinate(0) << ","
-    << getAtom().getCoordinate(1) << ","
-    << getAtom().getCoordinate(2) << ")";
-
-  std::cout << "(-";
-  if(getLeftChild() != NULL){
-    getLeftChild()->print();
-  }
-  std::cout << " +";
-  if(getRightChild() != NULL){
-    getRightChild()->print();
-  }
-  std::cout << ")";
-  return;
-}
-
 //////////////
 // ATOMTREE //
 //////////////
@@ -77,50 +18,81 @@ void AtomNode::print(){
 // CONSTRUCTOR
 
 AtomTree::AtomTree(){
-  _root = NULL;
   _max_rad = 0;
 }
 
-AtomTree::AtomTree(const std::vector<Atom>& list_of_atoms) : _atom_list(list_of_atoms){
-  _root = buildTree(0, getAtomList().size(), 0);
-  // ideally, the maximum radius would be the largest radius among all children of a node.
-  // this, however, may require running an algorithm for every tree node, increasing the
-  // complexity of the operation. it is much simpler to use the maximum radius among all
-  // atoms instead, sacrificing optimisation.
-  _max_rad = findMaxRad(getAtomList());
-}
-
-// DESTRUCTOR
-
-AtomTree::~AtomTree(){
-  delete _root;
+AtomTree::AtomTree(const std::vector<Atom>& list_of_atoms){
+  // the tree is built on a list of indices, so that each atom is only copied once, in tree order
+  std::array<std::vector<num_type>,3> coords;
+  for (char dim = 0; dim < 3; dim++){
+    coords[dim].resize(list_of_atoms.size());
+    for (size_t i = 0; i < list_of_atoms.size(); i++){
+      coords[dim][i] = list_of_atoms[i].getCoordinate(dim);
+    }
+  }
+  std::vector<size_t> order(list_of_atoms.size());
+  std::iota(order.begin(), order.end(), 0);
+  buildTree(order, coords, {0, order.size(), 0});
+  _atom_list.reserve(order.size());
+  for (const size_t i : order){
+    _atom_list.push_back(list_of_atoms[i]);
+  }
+  storeNodeData();
+  calcSubtreeBounds(getRoot());
+  _max_rad = findMaxRad(_atom_list);
 }
 
 // FUNCTIONS USED BY CONSTRUCTOR
 
-// recursive function to generate a 3-d tree from a list of atoms
-// rather than copying the list of atoms in every recursion, or saving the partitioned
-// vectors, the original list of atoms is passed by reference and only the vector limits
-// are passed by value. any sorting during the tree building occurs in the original list
-AtomNode* AtomTree::buildTree(
-    size_t vec_first, // index of first vector element (default 0)
-    size_t vec_end, // vector size (index of last element + 1)
-    char dim){
-  // if list of atoms has no atoms left
-  if((vec_end-vec_first)==0){
-    return NULL;
+// recursive function to generate a 3-d tree from a list of atom indices. only the median of
+// each range has to be in its final place, with smaller coordinates in front of it and larger
+// coordinates behind it. this is a selection rather than a sort, which takes linear time per
+// level of the tree, so O(n log n) in total, also for presorted coordinates
+void AtomTree::buildTree(std::vector<size_t>& order, const std::array<std::vector<num_type>,3>& coords, const Range& range){
+  // if list of atoms has at most one atom left
+  if (range.end - range.first <= 1){return;}
+  const std::vector<num_type>& coord = coords[range.dim];
+  std::nth_element(order.begin() + range.first, order.begin() + range.node(), order.begin() + range.end,
+      [&coord](const size_t a, const size_t b){return coord[a] < coord[b];});
+  buildTree(order, coords, range.left());
+  buildTree(order, coords, range.right());
+}
+
+// copies positions and radii out of the sorted list of atoms
+void AtomTree::storeNodeData(){
+  for (char dim = 0; dim < 3; dim++){
+    _pos[dim].resize(_atom_list.size());
   }
-  // if list of atoms has exactly one atom left
-  else if((vec_end-vec_first)==1){
-    return new AtomNode(this, vec_first,NULL,NULL);
+  _rad.resize(_atom_list.size());
+  for (size_t node = 0; node < _atom_list.size(); node++){
+    for (char dim = 0; dim < 3; dim++){
+      _pos[dim][node] = _atom_list[node].getCoordinate(dim);
+    }
+    _rad[node] = _atom_list[node].getRad();
   }
-
-  else{
-    quicksort(vec_first, vec_end, dim);
-    size_t median = vec_first + (vec_end-vec_first)/2; // operation rounds down
-    return new AtomNode(this, median, 
-        buildTree(vec_first, median, (dim+1)%3), 
-        buildTree(median+1, vec_end, (dim+1)%3));
+  _subtree_max_rad.resize(_atom_list.size());
+  _box_min.resize(_atom_list.size());
+  _box_max.resize(_atom_list.size());
+}
+
+// bounding box and maximum radius of each subtree, computed from the children upwards
+void AtomTree::calcSubtreeBounds(const Range& range){
+  if (range.empty()){return;}
+  const size_t node = range.node();
+  _subtree_max_rad[node] = _rad[node];
+  for (char dim = 0; dim < 3; dim++){
+    _box_min[node][dim] = _pos[dim][node];
+    _box_max[node][dim] = _pos[dim][node];
+  }
+  for (const Range& child : {range.left(), range.right()}){
+    if (child.empty()){continue;}
+    calcSubtreeBounds(child);
+    const size_t child_node = child.node();
+    _subtree_max_rad[node] = std::max(_subtree_max_rad[node], _subtree_max_rad[child_node]);
+    for (char dim = 0; dim < 3; dim++){
+      _box_min[node][dim] = std::min(_box_min[node][dim], _box_min[child_node][dim]);
+      _box_max[node][dim] = std::max(_box_max[node][dim], _box_max[child_node][dim]);
+    }
   }
 }
 
@@ -135,55 +107,41 @@ double findMaxRad(std::vector<Atom>& list_of_atoms){
 }
 
 
-void AtomTree::quicksort(const size_t vec_first, const size_t vec_end, const char dim){
-
-  if(vec_first+1 >= vec_end){
-    return;
-  }
-
-  double pivot = _atom_list[vec_end-1].getCoordinate(dim);
-
-  int cntr = vec_first;
-
-  for(int i = vec_first; i < vec_end; i++){
-    if(_atom_list[i].getCoordinate(dim) <= pivot){
-      swap(_atom_list[cntr], _atom_list[i]);
-      cntr++;
-    }
-  }
-  quicksort(vec_first, cntr-1, dim);
-  quicksort(cntr, vec_end, dim);
-
-  return;
-}
-
-void AtomTree::swap(Atom& a, Atom& b){
-  Atom temp = a;
-  a = b;
-  b = temp;
-  return;
-}
-
 // for testing
 void AtomTree::print() const {
   std::cout << "Printing Tree" << std::endl;
-  if(_root == NULL){
+  if(_atom_list.empty()){
     std::cout << "Tree empty" << std::endl;
   }
   else{
-    _root->print();
+    print(getRoot());
   }
   std::cout << std::endl;
   return;
 }
 
-// ACCESS
+void AtomTree::print(const Range& range) const {
+  const Atom& atom = _atom_list[range.node()];
+  std::cout << atom.symbol << "("
+    << atom.getCoordinate(0) << ","
+    << atom.getCoordinate(1) << ","
+    << atom.getCoordinate(2) << ")";
 
-const std::vector<Atom>& AtomTree::getAtomList() const {
-  return _atom_list;
+  std::cout << "(-";
+  if(!range.left().empty()){
+    print(range.left());
+  }
+  std::cout << " +";
+  if(!range.right().empty()){
+    print(range.right());
+  }
+  std::cout << ")";
+  return;
 }
 
-std::vector<Atom>& AtomTree::getAtomList() {
+// ACCESS
+
+const std::vector<Atom>& AtomTree::getAtomList() const {
   return _atom_list;
 }
 
@@ -191,8 +149,8 @@ const double AtomTree::getMaxRad() const {
   return _max_rad;
 }
 
-const AtomNode* AtomTree::getRoot() const {
-  return _root;
+AtomTree::Range AtomTree::getRoot() const {
+  return {0, _atom_list.size(), 0};
 }
 
 // Returns a vector containing atom IDs of all atoms whose distance from the atom's center
@@ -200,41 +158,19 @@ const AtomNode* AtomTree::getRoot() const {
 // Can be used to find all atoms that are touching or intersecting a sphere.
 std::vector<size_t> AtomTree::listAllWithin(const typename AtomTree::pos_type pos, const double max_dist) const {
   std::vector<size_t> id_list;
-
-  std::vector<std::pair<AtomNode*,char>> to_visit;
-  to_visit.push_back(std::make_pair(_root,0));
-  
-  while (!to_visit.empty()) {
-    auto node_dim = to_visit.back();
-    to_visit.pop_back();
-    // Skip if nullptr
-    if (node_dim.first == nullptr) continue;
-    AtomNode& node = *node_dim.first;
-    char dim = node_dim.second;
-
-    num_type at_pos_dim = node.getAtom().getCoordinate(dim);
-    num_type dist1D = pos[dim] - at_pos_dim;
-
-    // If distance along current direction is smaller than threshold then check
-    // this node's atom for match and visit both children.
-    if (abs(dist1D) <= max_dist + _max_rad) {
-
-      if (distance(node.getAtom().getPos(), pos) <= max_dist + node.getAtom().rad) {
-        id_list.push_back(node.getAtomId());
-      }
-
-      to_visit.push_back(std::make_pair(node.getLeftChild(), (dim+1)%3));
-      to_visit.push_back(std::make_pair(node.getRightChild(), (dim+1)%3));
-    }
-    // If distance is larger then visit either left or right child, depending on
-    // relation of the atom and the point.
-    else {
-      to_visit.push_back(std::make_pair(
-            dist1D < 0? node.getLeftChild() : node.getRightChild(),
-            (dim+1)%3));
-    }
-  }
-
+  listAllWithin(id_list, getRoot(), Vector(pos), max_dist);
   return id_list;
 }
 
+void AtomTree::listAllWithin(std::vector<size_t>& id_list, const Range& range, const Vector& pos, const double max_dist) const {
+  if (range.empty()){return;}
+  const size_t node = range.node();
+  // skip the subtree if even its largest atom cannot reach the point
+  if (pow(squaredDistToBox(node, pos), 0.5) > max_dist + _subtree_max_rad[node]){return;}
+
+  if (distance(getPosVec(node), pos) <= max_dist + _rad[node]) {
+    id_list.push_back(node);
+  }
+  listAllWithin(id_list, range.left(), pos, max_dist);
+  listAllWithin(id_list, range.right(), pos, max_dist);
+}
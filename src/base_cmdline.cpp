@@ -9,6 +9,7 @@
 #include "misc.h"
 #include "flags.h"
 #include "special_chars.h"
+#include "searchindex.h"
 #include <cassert>
 #include <sstream>
 
@@ -23,15 +24,20 @@ static const wxCmdLineEntryDesc s_cmd_line_desc[] =
   // optional
   { wxCMD_LINE_OPTION, "fe", "file-elements", "Path to the elements file", wxCMD_LINE_VAL_STRING},
   { wxCMD_LINE_OPTION, "do", "dir-output", "Path to the output directory", wxCMD_LINE_VAL_STRING},
+  { wxCMD_LINE_OPTION, "dc", "dir-cache", "Path to a directory that keeps neighbour search tables between runs", wxCMD_LINE_VAL_STRING},
   { wxCMD_LINE_OPTION, "r2", "radius2", "Large probe radius (for two-probe mode)", wxCMD_LINE_VAL_DOUBLE},
   { wxCMD_LINE_OPTION, "d", "depth", "Octree depth", wxCMD_LINE_VAL_NUMBER},
+  { wxCMD_LINE_OPTION, "t", "threads", "Number of threads for the calculation (default:1, 0 for all cores)", wxCMD_LINE_VAL_NUMBER},
   { wxCMD_LINE_SWITCH, "ht", "hetatm", "Include HETATM from pdb file", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "uc", "unitcell", "Evaluate unit cell", wxCMD_LINE_VAL_NONE, 0},
+  { wxCMD_LINE_SWITCH, "sp", "sparse", "Only allocate memory for voxels that are split (slower, for large structures)", wxCMD_LINE_VAL_NONE, 0},
+  { wxCMD_LINE_SWITCH, "ed", "distance-transform", "Use a distance transform to speed up the neighbour search (same results)", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "sf", "surface", "Calculate surfaces", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "xr", "export-report", "Export report (requires:-do)", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "xt", "export-total", "Export total surface map (requires:-do)", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "xc", "export-cavities", "Export surface maps for all cavities (requires:-do)", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_OPTION, "o", "output", "Control what parts of the output to display (default:all)", wxCMD_LINE_VAL_STRING},
+  { wxCMD_LINE_OPTION, "pf", "profile", "Display timings and counters of the calculation stages (format: json)", wxCMD_LINE_VAL_STRING},
   { wxCMD_LINE_SWITCH, "q", "quiet", "Silence progress reporting", wxCMD_LINE_VAL_NONE, 0},
   { wxCMD_LINE_SWITCH, "un", "unicode", "Allow unicode output", wxCMD_LINE_VAL_NONE},
   { wxCMD_LINE_SWITCH, "v", "version", "Display the app version", wxCMD_LINE_VAL_NONE},
@@ -43,6 +49,8 @@ static const std::vector<std::string> s_required_args = {"radius", "grid", "file
 bool validateProbes(const double, const double, const bool);
 bool validateExport(const std::string, const std::vector<bool>);
 bool validatePdb(const std::string, const bool, const bool);
+bool validateThreads(const long);
+bool validateProfile(const std::string);
 unsigned evalDisplayOptions(const std::string);
 
 // return true to supress GUI, return false to open GUI
@@ -103,37 +111,50 @@ void MainApp::evalCmdLine(){
   // optional arguments with default values
   wxString elements_file_path = Ctrl::getDefaultElemPath();
   wxString output_dir_path = "";
+  wxString cache_dir_path = "";
   wxString output = "all";
+  wxString profile_format = "";
   double probe_radius_l = 0;
   long tree_depth = 4;
+  long n_threads = 1;
   bool opt_include_hetatm = false;
   bool opt_unit_cell = false;
   bool opt_surface_area = false;
   bool opt_probe_mode = false;
+  bool opt_sparse_grid = false;
+  bool opt_distance_transform = false;
   bool exp_report = false;
   bool exp_total_map = false;
   bool exp_cavity_maps = false;
 
   parser.Found("fe",&elements_file_path);
   parser.Found("do",&output_dir_path);
+  parser.Found("dc",&cache_dir_path);
   parser.Found("o",&output);
+  const bool opt_profile = parser.Found("pf",&profile_format);
   parser.Found("r2",&probe_radius_l);
   parser.Found("d",&tree_depth);
+  parser.Found("t",&n_threads);
   opt_include_hetatm = parser.Found("ht");
   opt_unit_cell = parser.Found("uc");
   opt_surface_area = parser.Found("sf");
   opt_probe_mode = parser.Found("r") && parser.Found("r2");
+  opt_sparse_grid = parser.Found("sp");
+  opt_distance_transform = parser.Found("ed");
   exp_report = parser.Found("xr");
   exp_total_map = parser.Found("xt");
   exp_cavity_maps = parser.Found("xc");
 
   if(!validateProbes(probe_radius_s, probe_radius_l, opt_probe_mode)
       || !validateExport(output_dir_path.ToStdString(), {exp_report, exp_total_map, exp_cavity_maps})
-      || !validatePdb(structure_file_path.ToStdString(), opt_include_hetatm, opt_unit_cell)){
+      || !validatePdb(structure_file_path.ToStdString(), opt_include_hetatm, opt_unit_cell)
+      || !validateThreads(n_threads)
+      || (opt_profile && !validateProfile(profile_format.ToStdString()))){
     return;
   }
 
   unsigned display_flag = evalDisplayOptions(output.ToStdString());
+  SearchIndex::setCacheDir(cache_dir_path.ToStdString());
 
   // run calculation
   Ctrl::getInstance()->runCalculation(
@@ -151,6 +172,10 @@ void MainApp::evalCmdLine(){
       exp_report,
       exp_total_map,
       exp_cavity_maps,
+      (unsigned)n_threads,
+      opt_sparse_grid,
+      opt_distance_transform,
+      opt_profile,
       display_flag);
 }
 
@@ -171,6 +196,22 @@ bool validateExport(const std::string out_dir, const std::vector<bool> exp_optio
   return true;
 }
 
+bool validateThreads(const long n_threads){
+  if (n_threads < 0){
+    Ctrl::getInstance()->displayErrorMessage(904);
+    return false;
+  }
+  return true;
+}
+
+bool validateProfile(const std::string format){
+  if (format != "json"){
+    Ctrl::getInstance()->displayErrorMessage(905);
+    return false;
+  }
+  return true;
+}
+
 bool validatePdb(const std::string file, const bool hetatm, const bool unitcell){
   if ((fileExtension(file) != "pdb" && fileExtension(file) != "cif") && (hetatm || unitcell)){
     Ctrl::getInstance()->displayErrorMessage(115);
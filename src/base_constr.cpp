@@ -19,7 +19,6 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos, const wxSize &si
 #endif
   
   Ctrl::getInstance()->registerView(this);
-  InitMessageQueue();
   InitTopLevel();
 
 #ifdef MOLOVOL_RENDERER
@@ -48,10 +48,7 @@ int MainApp::OnExit(){
 }
 
 void MainFrame::OnClose(wxCloseEvent& event){
-  if (_abort_q->IsOk()){
-    _abort_q->Post(true);
-  }
-  delete _abort_q;
+  Ctrl::getInstance()->setAbortFlag(true);
   if (GetThread() && GetThread()->IsRunning()){
     GetThread()->Wait();
   }
@@ -75,6 +72,9 @@ void MainFrame::OnCalc(wxCommandEvent& event){
   abortButton->Enable(true);
   wxYield(); // without wxYield, the clicks on disabled buttons are queued
 
+  // clear the abort flag before the worker thread starts, so that an abort clicked right after
+  // the start is not lost
+  Ctrl::getInstance()->setAbortFlag(false);
   // create worker thread
   if (CreateThread(wxTHREAD_JOINABLE) != wxTHREAD_NO_ERROR){
     wxLogError("Could not create worker thread!");
@@ -100,22 +100,14 @@ wxThread::ExitCode MainFrame::Entry(){
 }
 
 void MainFrame::OnAbort(wxCommandEvent& event){
-  if (_abort_q->IsOk()){
-    _abort_q->Post(true);
-  }
+  // the token is atomic, so the worker threads see the abort without waiting for the next poll
+  Ctrl::getInstance()->setAbortFlag(true);
   if (GetThread() && GetThread()->IsRunning()){
     GetThread()->Wait();
   }
 }
 
-bool MainFrame::receivedAbortCommand(){
-  bool abort = false;
-  _abort_q->ReceiveTimeout(0,abort);
-  return abort;
-}
-
 void MainFrame::OnCalculationFinished(wxCommandEvent& event){
-  _abort_q->Clear();
   // main thread will wait for the thread to finish its work
   if (GetThread() && GetThread()->IsRunning()){
     GetThread()->Wait();
@@ -237,7 +229,7 @@ void MainFrame::OnTextInput(wxCommandEvent& event){
   }
 }
 
-const Container3D<Voxel>& MainFrame::getSurfaceData() const {
+const Space& MainFrame::getSurfaceData() const {
   return Ctrl::getInstance()->getSurfaceData();
 }
 
@@ -8,8 +8,7 @@
 #include "special_chars.h"
 #include "misc.h"
 #include "flags.h"
-#include "container3d.h"
-#include "voxel.h"
+#include "space.h"
 #include <string>
 #include <wx/msgdlg.h>
 
@@ -52,12 +51,14 @@ void MainFrame::extOpenErrorDialog(const int error_code, const std::string& erro
   GetEventHandler()->CallAfter(&MainFrame::openErrorDialog, code_message);
 }
 
-void MainFrame::extRenderSurface(const Container3D<Voxel>& surf_data, const std::array<double,3> origin, 
-    const double grid_step, const bool probe_mode, const unsigned char n_cavities, const std::vector<Atom>& atomlist){
+void MainFrame::extRenderSurface(const Space& surf_data, const std::array<double,3> origin, 
+    const double grid_step, const bool probe_mode, const size_t n_cavities, const std::vector<Atom>& atomlist){
 
-  auto render = [this, surf_data, origin, grid_step, probe_mode, n_cavities, atomlist](){
+  // the space is owned by the model and stays valid until the next calculation is started
+  const Space* surf_data_ptr = &surf_data;
+  auto render = [this, surf_data_ptr, origin, grid_step, probe_mode, n_cavities, atomlist](){
     renderMolecule(atomlist);
-    renderSurface(surf_data, origin, grid_step, std::make_pair(probe_mode, n_cavities));
+    renderSurface(*surf_data_ptr, origin, grid_step, std::make_pair(probe_mode, n_cavities));
   };
 
   GetEventHandler()->CallAfter(render);
@@ -278,8 +279,8 @@ void MainFrame::renderMolecule(const std::vector<Atom>& atomlist){
 #endif
 }
 
-void MainFrame::renderSurface(const Container3D<Voxel>& surf_data, const std::array<double,3> origin, 
-    const double grid_step, const std::pair<bool,unsigned char> args){
+void MainFrame::renderSurface(const Space& surf_data, const std::array<double,3> origin, 
+    const double grid_step, const std::pair<bool,size_t> args){
 #ifdef MOLOVOL_RENDERER
   m_renderWin->UpdateSurface(surf_data, origin, grid_step, args.first, args.second);
   
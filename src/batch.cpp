@@ -0,0 +1,389 @@
+#include "batch.h"
+#include "profile.h"
+#include "misc.h"
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <cctype>
+#include <limits>
+#include <set>
+
+/////////////////
+// JOB PARSING //
+/////////////////
+
+// largest depth of the grid, the same as the limit of the depth input in the gui
+static const long s_max_depth = 20;
+
+// reads the values of a job line. only the subset of JSON that is used by jobs is supported: strings,
+// numbers, booleans, arrays of strings and objects with numeric values
+class JobReader{
+  public:
+    JobReader(const std::string& line) : _line(line), _pos(0){}
+
+    void skipWhiteSpaces(){
+      while (_pos < _line.size() && std::isspace(static_cast<unsigned char>(_line[_pos]))){++_pos;}
+    }
+
+    // skips white spaces and consumes the character, if it is the next one
+    bool consume(const char c){
+      skipWhiteSpaces();
+      if (_pos < _line.size() && _line[_pos] == c){
+        ++_pos;
+        return true;
+      }
+      return false;
+    }
+
+    bool atEnd(){
+      skipWhiteSpaces();
+      return _pos == _line.size();
+    }
+
+    bool readString(std::string& str){
+      if (!consume('"')){return false;}
+      str.clear();
+      while (_pos < _line.size()){
+        const char c = _line[_pos++];
+        if (c == '"'){return true;}
+        if (c != '\\'){
+          str += c;
+          continue;
+        }
+        if (_pos == _line.size()){return false;}
+        const char escaped = _line[_pos++];
+        switch (escaped){
+          case '"': case '\\': case '/': str += escaped; break;
+          case 'b': str += '\b'; break;
+          case 'f': str += '\f'; break;
+          case 'n': str += '\n'; break;
+          case 'r': str += '\r'; break;
+          case 't': str += '\t'; break;
+          case 'u': if (!readCodePoint(str)){return false;} break;
+          default: return false;
+        }
+      }
+      return false;
+    }
+
+    bool readNumber(double& value){
+      skipWhiteSpaces();
+      const char* begin = _line.c_str() + _pos;
+      char* end;
+      value = std::strtod(begin, &end);
+      if (end == begin || !std::isfinite(value)){return false;}
+      _pos += end - begin;
+      return true;
+    }
+
+    bool readBool(bool& value){
+      skipWhiteSpaces();
+      for (const bool literal : {true, false}){
+        const std::string word = literal? "true" : "false";
+        if (_line.compare(_pos, word.size(), word) == 0){
+          _pos += word.size();
+          value = literal;
+          return true;
+        }
+      }
+      return false;
+    }
+
+  private:
+    // appends a \uXXXX escape sequence as UTF-8. surrogate pairs are not supported, since file paths and
+    // element symbols do not need them
+    bool readCodePoint(std::string& str){
+      if (_pos + 4 > _line.size()){return false;}
+      const std::string hex = _line.substr(_pos, 4);
+      if (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos){return false;}
+      const unsigned long cp = std::stoul(hex, nullptr, 16);
+      if (cp >= 0xD800 && cp <= 0xDFFF){return false;}
+      _pos += 4;
+      if (cp < 0x80){
+        str += char(cp);
+      }
+      else if (cp < 0x800){
+        str += char(0xC0 | (cp >> 6));
+        str += char(0x80 | (cp & 0x3F));
+      }
+      else {
+        str += char(0xE0 | (cp >> 12));
+        str += char(0x80 | ((cp >> 6) & 0x3F));
+        str += char(0x80 | (cp & 0x3F));
+      }
+      return true;
+    }
+
+    const std::string& _line;
+    size_t _pos;
+};
+
+// reads the value of a key into the job
+static bool readJobValue(JobReader& reader, const std::string& key, BatchJob& job, std::string& error){
+  CalcParameters& param = job.param;
+  auto readStringTo = [&](std::string& str){
+    if (reader.readString(str)){return true;}
+    error = "\"" + key + "\" must be a string";
+    return false;
+  };
+  auto readBoolTo = [&](bool& value){
+    if (reader.readBool(value)){return true;}
+    error = "\"" + key + "\" must be true or false";
+    return false;
+  };
+  auto readPositive = [&](double& value){
+    if (reader.readNumber(value) && value > 0){return true;}
+    error = "\"" + key + "\" must be a positive number";
+    return false;
+  };
+  auto readInteger = [&](long& value, const long min, const long max){
+    double number;
+    if (reader.readNumber(number) && number == std::floor(number) && number >= min && number <= max){
+      value = long(number);
+      return true;
+    }
+    error = "\"" + key + "\" must be an integer from " + std::to_string(min) + " to " + std::to_string(max);
+    return false;
+  };
+
+  if (key == "id"){
+    // numeric ids are accepted and returned as strings
+    double number;
+    if (reader.readString(job.id)){return true;}
+    if (reader.readNumber(number)){
+      std::ostringstream ss;
+      ss << std::setprecision(15) << number;
+      job.id = ss.str();
+      return true;
+    }
+    error = "\"id\" must be a string or a number";
+    return false;
+  }
+  if (key == "file-structure"){return readStringTo(param.atom_file_path);}
+  if (key == "file-elements"){return readStringTo(param.elem_file_path);}
+  if (key == "radius"){return readPositive(param.r_probe1);}
+  if (key == "radius2"){
+    param.probe_mode = true;
+    return readPositive(param.r_probe2);
+  }
+  if (key == "grid"){return readPositive(param.grid_step);}
+  if (key == "depth"){
+    long depth;
+    if (!readInteger(depth, 0, s_max_depth)){return false;}
+    param.max_depth = int(depth);
+    return true;
+  }
+  if (key == "threads"){
+    long n_threads;
+    if (!readInteger(n_threads, 0, std::numeric_limits<int>::max())){return false;}
+    param.n_threads = unsigned(n_threads);
+    return true;
+  }
+  if (key == "hetatm"){return readBoolTo(param.inc_hetatm);}
+  if (key == "unitcell"){return readBoolTo(param.analyze_unit_cell);}
+  if (key == "surface"){return readBoolTo(param.calc_surface_areas);}
+  if (key == "sparse"){return readBoolTo(param.sparse_grid);}
+  if (key == "distance-transform"){return readBoolTo(param.distance_transform);}
+  if (key == "profile"){return readBoolTo(param.profile);}
+  if (key == "radii"){
+    error = "\"radii\" must be an object of element symbols and non-negative radii";
+    if (!reader.consume('{')){return false;}
+    if (reader.consume('}')){
+      error.clear();
+      return true;
+    }
+    do {
+      std::string symbol;
+      double radius;
+      if (!reader.readString(symbol) || !reader.consume(':') || !reader.readNumber(radius) || radius < 0){return false;}
+      param.radius_map[symbol] = radius;
+    } while (reader.consume(','));
+    if (!reader.consume('}')){return false;}
+    error.clear();
+    return true;
+  }
+  if (key == "elements"){
+    error = "\"elements\" must be an array of element symbols";
+    if (!reader.consume('[')){return false;}
+    if (reader.consume(']')){
+      error.clear();
+      return true;
+    }
+    do {
+      std::string symbol;
+      if (!reader.readString(symbol)){return false;}
+      param.included_elements.push_back(symbol);
+    } while (reader.consume(','));
+    if (!reader.consume(']')){return false;}
+    error.clear();
+    return true;
+  }
+  error = "unknown key \"" + key + "\"";
+  return false;
+}
+
+bool parseBatchJob(const std::string& line, BatchJob& job, std::string& error){
+  JobReader reader(line);
+  job.param = CalcParameters();
+  std::set<std::string> keys;
+  if (!reader.consume('{')){
+    error = "a job must be a JSON object";
+    return false;
+  }
+  if (!reader.consume('}')){
+    do {
+      std::string key;
+      if (!reader.readString(key) || !reader.consume(':')){
+        error = "expected a key followed by ':'";
+        return false;
+      }
+      if (!readJobValue(reader, key, job, error)){return false;}
+      keys.insert(key);
+    } while (reader.consume(','));
+    if (!reader.consume('}')){
+      error = "expected ',' or '}'";
+      return false;
+    }
+  }
+  if (!reader.atEnd()){
+    error = "unexpected characters after the job";
+    return false;
+  }
+  // the same arguments are required as on the command line
+  for (const std::string required : {"file-structure", "radius", "grid"}){
+    if (!keys.count(required)){
+      error = "\"" + required + "\" is required";
+      return false;
+    }
+  }
+  if ((job.param.inc_hetatm || job.param.analyze_unit_cell)
+      && fileExtension(job.param.atom_file_path) != "pdb" && fileExtension(job.param.atom_file_path) != "cif"){
+    error = "\"hetatm\" and \"unitcell\" require a pdb or cif structure file";
+    return false;
+  }
+  if (job.param.probe_mode && job.param.r_probe2 < job.param.r_probe1){
+    error = "\"radius2\" must not be smaller than \"radius\"";
+    return false;
+  }
+  return true;
+}
+
+///////////////////
+// RESULT OUTPUT //
+///////////////////
+
+static std::string jsonString(const std::string& str){
+  std::ostringstream json;
+  json << '"';
+  for (const char c : str){
+    switch (c){
+      case '"': json << "\\\""; break;
+      case '\\': json << "\\\\"; break;
+      case '\n': json << "\\n"; break;
+      case '\r': json << "\\r"; break;
+      case '\t': json << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20){
+          json << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+        }
+        else {
+          json << c;
+        }
+    }
+  }
+  json << '"';
+  return json.str();
+}
+
+std::string batchResultToJson(const BatchJob& job, CalcReportBundle& data, const std::vector<std::pair<int,std::string>>& errors){
+  std::ostringstream json;
+  json << std::setprecision(9);
+  json << "{\"id\":" << jsonString(job.id)
+    << ",\"file-structure\":" << jsonString(job.param.atom_file_path)
+    << ",\"success\":" << (data.success? "true" : "false");
+  if (data.success){
+    json << ",\"formula\":" << jsonString(data.chemical_formula)
+      << ",\"molar_mass\":" << data.molar_mass
+      << ",\"time\":" << data.getTime();
+
+    auto volume = [&data](const char type){
+      auto it = data.volumes.find(type);
+      return it == data.volumes.end()? 0 : it->second;
+    };
+    json << ",\"volumes\":{\"vol_vdw\":" << volume(0b00000011)
+      << ",\"vol_inaccessible\":" << volume(0b00000101)
+      << ",\"vol_mol\":" << volume(0b00000011) + volume(0b00000101)
+      << ",\"vol_core_s\":" << volume(0b00001001)
+      << ",\"vol_shell_s\":" << volume(0b00010001);
+    if (data.probe_mode){
+      json << ",\"vol_core_l\":" << volume(0b00100001)
+        << ",\"vol_shell_l\":" << volume(0b01000001);
+    }
+    json << "}";
+
+    if (data.calc_surface_areas){
+      json << ",\"surfaces\":{\"surf_vdw\":" << data.getSurfVdw()
+        << ",\"surf_mol\":" << data.getSurfMolecular()
+        << ",\"surf_excluded_s\":" << data.getSurfProbeExcluded()
+        << ",\"surf_accessible_s\":" << data.getSurfProbeAccessible() << "}";
+    }
+
+    json << ",\"cavities\":[";
+    for (size_t i = 0; i < data.cavities.size(); ++i){
+      const std::array<double,3> centre = data.getCavCentre(i);
+      json << (i? "," : "") << "{\"volume\":" << data.getCavVolume(i);
+      if (data.calc_surface_areas){
+        json << ",\"surf_core\":" << data.getCavSurfCore(i)
+          << ",\"surf_shell\":" << data.cavities[i].getSurfShell();
+      }
+      json << ",\"centre\":[" << centre[0] << "," << centre[1] << "," << centre[2] << "]}";
+    }
+    json << "]";
+
+    if (job.param.profile){
+      json << ",\"profile\":" << Profiler::toJson(data.stage_times, data.counters);
+    }
+  }
+  json << ",\"errors\":[";
+  for (size_t i = 0; i < errors.size(); ++i){
+    json << (i? "," : "") << "{\"code\":" << errors[i].first << ",\"message\":" << jsonString(errors[i].second) << "}";
+  }
+  json << "]}";
+  return json.str();
+}
+
+///////////////
+// BATCH RUN //
+///////////////
+
+unsigned runBatch(std::istream& jobs, std::ostream& results){
+  Model model;
+  Reporter& reporter = model.getReporter();
+  unsigned n_failed = 0;
+  size_t line_number = 0;
+  std::string line;
+  while (std::getline(jobs, line)){
+    ++line_number;
+    if (line.find_first_not_of(" \t\r") == std::string::npos){continue;}
+
+    BatchJob job;
+    std::string error;
+    reporter.clearErrors();
+    CalcReportBundle data = CalcReportBundle();
+    data.success = false;
+    if (parseBatchJob(line, job, error)){
+      data = model.calculate(job.param);
+    }
+    else {
+      reporter.displayErrorMessage(906, {std::to_string(line_number), error});
+    }
+    if (job.id.empty()){
+      job.id = std::to_string(line_number);
+    }
+    if (!data.success){++n_failed;}
+    // flushed, so that a process reading the results through a pipe receives every result immediately
+    results << batchResultToJson(job, data, reporter.getErrors()) << std::endl;
+  }
+  return n_failed;
+}
@@ -0,0 +1,56 @@
+#include "batch.h"
+#include "searchindex.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+
+// long running batch mode without user interface. jobs are read as JSON lines from a file or from the
+// standard input, so that a server can keep one process open and write jobs to its input. one result
+// line is written to the standard output for each job. the exit code is 1 if any job failed
+static void printUsage(){
+  std::cout << "Usage: molovol_batch [-dc <dir>] [<jobs file>]\n"
+    << "  <jobs file>         JSON lines file with one job per line. jobs are read from the standard input\n"
+    << "                      if no file or '-' is given\n"
+    << "  -dc, --dir-cache    Path to a directory that keeps neighbour search tables between runs\n"
+    << "  -v, --version       Print the version and exit\n"
+    << "  -h, --help          Print this message and exit\n";
+}
+
+int main(int argc, char* argv[]){
+  std::string jobs_path = "-";
+  for (int i = 1; i < argc; ++i){
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help"){
+      printUsage();
+      return 0;
+    }
+    else if (arg == "-v" || arg == "--version"){
+      std::cout << Model::getVersion() << std::endl;
+      return 0;
+    }
+    else if ((arg == "-dc" || arg == "--dir-cache") && i+1 < argc){
+      SearchIndex::setCacheDir(argv[++i]);
+    }
+    else if (arg == "-" || arg[0] != '-'){
+      jobs_path = arg;
+    }
+    else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  unsigned n_failed;
+  if (jobs_path == "-"){
+    n_failed = runBatch(std::cin, std::cout);
+  }
+  else {
+    std::ifstream jobs(jobs_path);
+    if (!jobs){
+      std::cerr << "Could not open jobs file: " << jobs_path << std::endl;
+      return 2;
+    }
+    n_failed = runBatch(jobs, std::cout);
+  }
+  return n_failed? 1 : 0;
+}
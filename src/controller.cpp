@@ -25,17 +25,11 @@ MainFrame* Ctrl::s_gui = NULL;
 ///////////////////////////
 
 std::string Ctrl::getDefaultElemPath(){
-#if defined(_WIN32)
-    std::string sep = "\\";
-#else
-    std::string sep = "/";
-#endif
-
-  return getResourcesDir() + sep + s_elem_file;
+  return Model::getDefaultElemPath();
 }
 
 std::string Ctrl::getVersion(){
-  return s_version;
+  return Model::getVersion();
 }
 
 ////////////////
@@ -86,6 +80,7 @@ bool Ctrl::loadElementsFile(){
   // ensures, that there is only ever one instance of the model class
   if(_current_calculation == NULL){
     _current_calculation = new Model();
+    _current_calculation->setReporter(*this);
   }
 
   std::string elements_filepath = s_gui->getElementsFilepath();
@@ -104,6 +99,7 @@ bool Ctrl::loadAtomFile(){
   // ensures, that there is only ever one instance of the model class
   if(_current_calculation == NULL){
     _current_calculation = new Model();
+    _current_calculation->setReporter(*this);
   }
 
   bool successful_import;
@@ -120,13 +116,12 @@ bool Ctrl::loadAtomFile(){
 
 // default function call: transfer data from GUI to Model
 bool Ctrl::runCalculation(){
-  // reset abort flag
-  setAbortFlag(false);
   s_gui->extSetProgressBar(0);
   // create an instance of the model class
   // ensures, that there is only ever one instance of the model class
   if(_current_calculation == NULL){
     _current_calculation = new Model();
+    _current_calculation->setReporter(*this);
   }
 
   // PARAMETERS
@@ -194,8 +189,15 @@ bool Ctrl::runCalculation(
     const bool exp_report,
     const bool exp_total_map,
     const bool exp_cavity_maps,
+    const unsigned n_threads,
+    const bool opt_sparse_grid,
+    const bool opt_distance_transform,
+    const bool opt_profile,
     const unsigned display_flag){
-  if(_current_calculation == NULL){_current_calculation = new Model();}
+  if(_current_calculation == NULL){
+    _current_calculation = new Model();
+    _current_calculation->setReporter(*this);
+  }
 
   try{_current_calculation->readAtomsFromFile(structure_file_path, opt_include_hetatm);}
   catch (const ExceptInvalidInputFile& e){
@@ -234,6 +236,10 @@ bool Ctrl::runCalculation(
     exp_cavity_maps,
     _current_calculation->getRadiusMap(),
     _current_calculation->listElementsInStructure());
+  _current_calculation->setNumThreads(n_threads);
+  _current_calculation->toggleSparseGrid(opt_sparse_grid);
+  _current_calculation->toggleDistanceTransform(opt_distance_transform);
+  _current_calculation->toggleProfile(opt_profile);
 
   CalcReportBundle data = _current_calculation->generateData();
 
@@ -241,6 +247,9 @@ bool Ctrl::runCalculation(
 
   displayInput(data, display_flag);
   displayResults(data, display_flag);
+  if (opt_profile){
+    notifyUser("<PROFILE>\n" + Profiler::toJson(data.stage_times, data.counters) + "\n");
+  }
 
   if (data.success){
     // export if appropriate option is toggled
@@ -470,7 +479,7 @@ void Ctrl::displayCavityList(CalcReportBundle& data, const unsigned display_flag
     s_gui->extDisplayCavityList(table);
   }
   else{
-    table.print();
+    table.print(*this);
   }
 }
 
@@ -513,14 +522,14 @@ void Ctrl::updateProgressBar(const int percentage){
   }
 }
 
-void Ctrl::renderSurface(const Container3D<Voxel>& surf_data, const std::array<double,3> origin, 
-    const double grid_step, const bool probe_mode, const unsigned char n_cavities, const std::vector<Atom>& atomlist) {
+void Ctrl::renderSurface(const Space& surf_data, const std::array<double,3> origin, 
+    const double grid_step, const bool probe_mode, const size_t n_cavities, const std::vector<Atom>& atomlist) {
   if (_to_gui) {
     s_gui->extRenderSurface(surf_data, origin, grid_step, probe_mode, n_cavities, atomlist);
   }
 }
 
-const Container3D<Voxel>& Ctrl::getSurfaceData() const {
+const Space& Ctrl::getSurfaceData() const {
   return _current_calculation->getSurfaceData();
 };
 
@@ -576,75 +585,19 @@ bool Ctrl::isCalculationDone(){
   return _calculation_finished;
 }
 
+// clearing the flag starts a new calculation, which also resets its progress
 void Ctrl::setAbortFlag(const bool state){
-  _abort_calculation = state;
-}
-
-bool Ctrl::getAbortFlag(){
-  return _abort_calculation;
-}
-
-// checks whether worker thread has received a signal to stop the calculation and
-// updates the progress of the calculation
-void Ctrl::updateCalculationStatus(){
-  if (_to_gui){
-    setAbortFlag(s_gui->receivedAbortCommand());
-  }
+  if (state){getProgressToken().requestAbort();}
+  else {getProgressToken().reset();}
 }
 
 ////////////////////
 // ERROR MESSAGES //
 ////////////////////
 
-static const std::map<int, std::string> s_error_codes = {
-  {0, "Unidentified error code."}, // no user should ever see this
-  // 1xx: Invalid Input
-  {100, "Import failed!"},
-  {101, "Invalid elements file. Please select a valid file or set radii manually. Atomic weights will be set to 0."},
-  {102, "Invalid structure file. Please select a valid file. You may need to enable the option HETATM for PDB files."},
-  {103, "Invalid file format. Please make sure that the input files have the correct file extensions."},
-  {104, "Invalid probe radius input. The large probe must have a larger radius than the small probe."},
-  {105, "Invalid entry in structure file encountered. Some atoms have not been imported. Please check the format of the input file."},
-  {106, "Invalid element symbol(s) in elements file detected. Some radii may be assigned incorrectly. Please make sure that all element symbols begin with an alphabetic character."},
-  {107, "Invalid radius value in elements file detected. Some radii may be set to 0. Please make sure that all radii are numeric."},
-  {108, "Invalid atomic weight value in elements file detected. Some atomic weights may be set to 0. Please make sure that all atomic weights are numeric."},
-  {109, "Invalid numeric input. Please make sure that all input values have a valid number format."},
-  // 11x: unit cell files
-  {111, "Space group not found. Check the structure file, or untick the Unit Cell Analysis tickbox."},
-  {112, "Invalid unit cell parameters. Check the structure file, or untick the Unit Cell Analysis tickbox."},
-  {113, "Space group or symmetry not found. Check the structure and space group files or untick the Unit Cell Analysis tickbox"},
-  {114, "Invalid ATOM or HETATM line encountered. Import may be incomplete. Check the structure file."},
-  {115, "Invalid option(s). You may have selected an option that is incompatible with the structure file format."},
-  // 2xx: Issue during Calculation
-  {200, "Calculation failed!"},
-  {201, "Total number of cavities (255) exceeded. Consider changing the probe size. Calculation will proceed."},
-  // 3xx: Issue with Output
-  {300, "Output failed!"},
-  {301, "Data missing to export file. Calculation may be still running or has not been started."},
-  {302, "Invalid output directory. Please select a valid output directory."},
-  {303, "An unidentified issue has been encountered while writing the surface map."},
-  // 9xx: Issues with command line arguments
-  {900, "Command line interface failed!"},
-  {902, "Invalid output display option. At least one parameter belonging to '-o' is invalid and will be ignored."},
-  {903, "Elements file import failed. Calculation aborted."},
-  // 9xx: Required command line arguments missing
-  {910, "Unexpected error. More than three required command line arguments appear to be missing."},
-  {911, "One required command line argument missing. Please provide --%s"},
-  {912, "Two required command line arguments missing. Please provide --%s and --%s"},
-  {913, "Three required command line arguments missing. Please provide --%s, --%s, and --%s"}
-};
-
 // Print error message either to GUI or console
 void Ctrl::displayErrorMessage(const int error_code, const std::vector<std::string>& str_fill){
-  std::string msg = getErrorMessage(error_code);
-
-  // Substitute place holders
-  size_t i = 0;
-  while (msg.find("%s") != std::string::npos){
-    assert(str_fill.size() > i);
-    msg.replace(msg.find("%s"), 2, str_fill[i]);
-    ++i;
-  }
+  const std::string msg = getErrorMessage(error_code, str_fill);
 
   if (_to_gui){
     // Print to GUI
@@ -655,12 +608,3 @@ void Ctrl::displayErrorMessage(const int error_code, const std::vector<std::stri
     std::cout << error_code << ": " << msg << std::endl;
   }
 }
-
-std::string Ctrl::getErrorMessage(const int error_code){
-  if (s_error_codes.find(error_code) == s_error_codes.end()) {
-    return s_error_codes.find(0)->second;
-  }
-  else {
-    return s_error_codes.find(error_code)->second;
-  }
-}
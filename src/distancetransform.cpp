@@ -0,0 +1,60 @@
+#include "distancetransform.h"
+#include <algorithm> // min
+
+// lower envelope of the parabolas f[p] + (q-p)^2 along one line of the grid. elements that are not
+// closer to a source than s_max_sq_dist cannot lower the result below s_max_sq_dist, so they are
+// left out. all values are integers and the intersections of the parabolas are compared as fractions,
+// so the result is exact
+void transformLine(const std::vector<int64_t>& f, std::vector<int64_t>& d, std::vector<int64_t>& v){
+  const int64_t n = f.size();
+  auto height = [&f](const int64_t p){return f[p] + p*p;};
+  v.clear();
+  for (int64_t q = 0; q < n; ++q){
+    if (f[q] >= s_max_sq_dist){continue;}
+    // remove parabolas that are hidden by the new one, i.e. whose intersection with the new one
+    // is left of their intersection with the previous one
+    while (v.size() > 1){
+      const int64_t p = v.back();
+      const int64_t o = v[v.size()-2];
+      if ((height(q) - height(p)) * (p - o) > (height(p) - height(o)) * (q - p)){break;}
+      v.pop_back();
+    }
+    v.push_back(q);
+  }
+  if (v.empty()){
+    std::fill(d.begin(), d.end(), s_max_sq_dist);
+    return;
+  }
+  size_t k = 0;
+  for (int64_t q = 0; q < n; ++q){
+    auto dist = [&f, q](const int64_t p){return f[p] + (q-p)*(q-p);};
+    while (k+1 < v.size() && dist(v[k+1]) <= dist(v[k])){k++;}
+    d[q] = std::min<int64_t>(dist(v[k]), s_max_sq_dist);
+  }
+}
+
+// every pass computes the minimum over one axis of the result of the previous pass. since the values
+// are capped after each pass, the capped result of the last pass is the same as capping the exact result
+void squaredDistanceTransform(std::vector<uint16_t>& grid, const std::array<unsigned long,3>& n){
+  const std::array<unsigned long,3> stride = {1, n[0], n[0]*n[1]};
+  std::vector<int64_t> f, d, v;
+  for (char axis = 0; axis < 3; ++axis){
+    // the two other axes enumerate the lines along the current axis
+    const char a = (axis+1)%3;
+    const char b = (axis+2)%3;
+    f.resize(n[axis]);
+    d.resize(n[axis]);
+    for (unsigned long i = 0; i < n[a]; ++i){
+      for (unsigned long j = 0; j < n[b]; ++j){
+        const unsigned long first = i*stride[a] + j*stride[b];
+        for (unsigned long q = 0; q < n[axis]; ++q){
+          f[q] = grid[first + q*stride[axis]];
+        }
+        transformLine(f, d, v);
+        for (unsigned long q = 0; q < n[axis]; ++q){
+          grid[first + q*stride[axis]] = d[q];
+        }
+      }
+    }
+  }
+}
@@ -1,5 +1,5 @@
 #include "griddata.h"
-#include "controller.h"
+#include "reporter.h"
 #include "misc.h"
 
 // GridCol definitions
@@ -35,7 +35,7 @@ bool GridData::hideCol(const int col) const{
   return columns[col].hide_col;
 }
 
-void GridData::print() const {
+void GridData::print(Reporter& reporter) const {
   constexpr int width = 20;
   
   for (size_t row = 0; row < getNumberRows(true); ++row){
@@ -44,13 +44,13 @@ void GridData::print() const {
       SomeText cell = col.getElem(row,true);
       cell.replaceNewlines();
       if (cell.str.empty()) {
-        Ctrl::getInstance()->notifyUser(wfield(width, cell.wstr));
+        reporter.notifyUser(wfield(width, cell.wstr));
       }
       else{
-        Ctrl::getInstance()->notifyUser(field(width, cell.str));
+        reporter.notifyUser(field(width, cell.str));
       }
     }
-    Ctrl::getInstance()->notifyUser("\n");
+    reporter.notifyUser("\n");
   }
 }
  
@@ -1,22 +1,19 @@
 #include "importmanager.h"
 #include "crystallographer.h"
 #include "misc.h"
-
-// This is a temporary fix so that we can wite unit tests for sections of the code
-#ifndef LIBRARY_BUILD
-#include "controller.h"
-#endif
+#include "reporter.h"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <iterator>
 
 ////////////////
 // XYZ IMPORT //
 ////////////////
-std::vector<Atom> ImportMngr::readFileXYZ(const std::string& filepath){
+std::vector<Atom> ImportMngr::readFileXYZ(const std::string& filepath, Reporter* reporter){
   // Validate and read atom line
   // If invalid, returns a pair, whose first value is an empty string
   auto readAtomLine = [](const std::string& line){
@@ -65,9 +62,7 @@ std::vector<Atom> ImportMngr::readFileXYZ(const std::string& filepath){
   }
   inp_file.close();
   if (invalid_entry_encountered){
-    #ifndef LIBRARY_BUILD
-    Ctrl::getInstance()->displayErrorMessage(105);
-    #endif
+    if (reporter){reporter->displayErrorMessage(105);}
     }
   return atom_list;
 }
@@ -75,7 +70,7 @@ std::vector<Atom> ImportMngr::readFileXYZ(const std::string& filepath){
 ////////////////
 // PDB IMPORT //
 ////////////////
-std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFilePDB(const std::string& filepath, bool include_hetatm){
+std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFilePDB(const std::string& filepath, bool include_hetatm, Reporter* reporter){
   // LAMBDA DEFINITIONS
   // Follows the official specifications for PDB files as detailed in "Protein 
   // Data Bank Contents Guide: Atomic Coordinate Entry Format Description" Version 3.3
@@ -182,19 +177,13 @@ std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFilePDB(const
   }
   inp_file.close();
   if (invalid_symbol_detected){
-    #ifndef LIBRARY_BUILD
-    Ctrl::getInstance()->displayErrorMessage(105);
-    #endif
+    if (reporter){reporter->displayErrorMessage(105);}
   }
   if (invalid_cell_params){
-    #ifndef LIBRARY_BUILD
-    Ctrl::getInstance()->displayErrorMessage(112);
-    #endif
+    if (reporter){reporter->displayErrorMessage(112);}
   }
   if (invalid_atom_line){
-    #ifndef LIBRARY_BUILD
-    Ctrl::getInstance()->displayErrorMessage(114);
-    #endif
+    if (reporter){reporter->displayErrorMessage(114);}
   }
   return std::make_pair(atom_list,uc);
 }
@@ -204,7 +193,7 @@ std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFilePDB(const
 ////////////////
 // this function will successfully extract data from standard cif files such as those generated by Mercury program
 // however, due to the permissive format of cif files, this function might fail in some occasions
-std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFileCIF(const std::string& filepath){
+std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFileCIF(const std::string& filepath, Reporter* reporter){
   std::string line; // line in cif file
   std::string no_ws_line; // line in cif file with whitespaces removed
   std::ifstream inp_file(filepath);
@@ -390,9 +379,7 @@ std::pair<std::vector<Atom>,ImportMngr::UnitCell> ImportMngr::readFileCIF(const
 
   auto atom_list_result = convertCifAtomsList(atom_data, uc.cart_matrix);
   if (!atom_list_result.first){
-    #ifndef LIBRARY_BUILD
-    Ctrl::getInstance()->displayErrorMessage(105); // at least one atom line could not be read
-    #endif
+    if (reporter){reporter->displayErrorMessage(105);} // at least one atom line could not be read
   }
   return std::make_pair(atom_list_result.second, uc);
 }
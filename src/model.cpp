@@ -1,21 +1,20 @@
 #include "model.h"
 #include "crystallographer.h"
-#include "controller.h"
 #include "atom.h"
 #include "misc.h"
-#include "special_chars.h"
 #include "exception.h"
 #include <chrono>
 #include <array>
 #include <string>
 #include <vector>
 #include <cmath>
+#include <limits>
 
 //////////////////////
 // CALCRESULTBUNDLE //
 //////////////////////
 
-std::array<double,3> CalcReportBundle::getCavCentre(const unsigned char i){
+std::array<double,3> CalcReportBundle::getCavCentre(const size_t i){
   std::array<double,3> cav_ctr;
   for (char j = 0; j < 3; ++j){
     cav_ctr[j] = (cavities[i].min_bound[j] + cavities[i].max_bound[j])/2;
@@ -57,7 +56,7 @@ bool Model::setParameters(const std::string file_path,
   _data.atom_file_path = file_path;
   _output_folder = output_dir;
   if (_output_folder.empty() && (make_report || make_full_map || make_cav_maps)){
-    Ctrl::getInstance()->displayErrorMessage(302);
+    _reporter->displayErrorMessage(302);
     return false;
   }
   _data.inc_hetatm = inc_hetatm;
@@ -85,7 +84,7 @@ bool Model::setProbeRadii(const double r_1, const double r_2, const bool probe_m
     // This second check would be unnecessary when using the GUI but
     // adding it here makes the back engine Model error-proof independently from the GUI
     if (r_1 > r_2){
-      Ctrl::getInstance()->displayErrorMessage(104);
+      _reporter->displayErrorMessage(104);
       return false;
     }
     else{
@@ -99,17 +98,74 @@ bool Model::setProbeRadii(const double r_1, const double r_2, const bool probe_m
 // CALCULATION ENTRY //
 ///////////////////////
 
+CalcReportBundle Model::calculate(const CalcParameters& param){
+  _reporter->getProgressToken().reset();
+  auto fail = [&param](){
+    CalcReportBundle data = CalcReportBundle();
+    data.success = false;
+    data.atom_file_path = param.atom_file_path;
+    return data;
+  };
+
+  const std::string elem_file_path = param.elem_file_path.empty()? getDefaultElemPath() : param.elem_file_path;
+  if (elem_file_path != _elem_file_path){
+    _elem_file_path.clear();
+    if (!importElemFile(elem_file_path)){
+      _reporter->displayErrorMessage(903);
+      return fail();
+    }
+    _elem_file_path = elem_file_path;
+    _elem_file_radius_map = _radius_map;
+  }
+
+  try{
+    if (!readAtomsFromFile(param.atom_file_path, param.inc_hetatm)){return fail();}
+  }
+  catch (const ExceptInvalidInputFile& e){
+    _reporter->displayErrorMessage(102);
+    return fail();
+  }
+  catch (const ExceptIllegalFileExtension& e){
+    _reporter->displayErrorMessage(103);
+    return fail();
+  }
+  catch (const ExceptInvalidCellParams& e){
+    _reporter->displayErrorMessage(109);
+    return fail();
+  }
+
+  std::unordered_map<std::string, double> radius_map = _elem_file_radius_map;
+  for (const auto& [symbol, radius] : param.radius_map){
+    radius_map[symbol] = radius;
+  }
+  if (!setParameters(param.atom_file_path, "", param.inc_hetatm, param.analyze_unit_cell,
+        param.calc_surface_areas, param.probe_mode, param.r_probe1, param.r_probe2, param.grid_step,
+        param.max_depth, false, false, false, radius_map,
+        param.included_elements.empty()? listElementsInStructure() : param.included_elements)){
+    return fail();
+  }
+  setNumThreads(param.n_threads);
+  toggleSparseGrid(param.sparse_grid);
+  toggleDistanceTransform(param.distance_transform);
+  toggleProfile(param.profile);
+  return generateData();
+}
+
 CalcReportBundle Model::generateData(){
   // save the date and time of calculation for output files
   _time_stamp = timeNow();
+  Profiler::enable(optionProfile());
+  Profiler::reset();
   CalcReportBundle data;
   data = generateVolumeData();
-  if(Ctrl::getInstance()->getAbortFlag()){return data;}
+  if(_reporter->getAbortFlag()){return data;}
   // surface calculation requires running the volume calculation first, but shouldn't be inside the volume calc function
   if (optionCalcSurfaceAreas() && data.success){
     data = generateSurfaceData();
   }
-  return data;
+  _data.stage_times = Profiler::collectStages();
+  _data.counters = Profiler::collectCounts();
+  return _data;
 }
 
 CalcReportBundle Model::generateVolumeData(){
@@ -120,15 +176,18 @@ CalcReportBundle Model::generateVolumeData(){
     auto start = std::chrono::steady_clock::now();
     bool cavities_exceeded = false;
     _cell.assignTypeInGrid(_atoms, _data.cavities, getProbeRad1(), getProbeRad2(), optionProbeMode(), cavities_exceeded);
-    if(Ctrl::getInstance()->getAbortFlag()){
+    if(_reporter->getAbortFlag()){
       _data.success = false;
       return _data;
     }
-    if(cavities_exceeded){Ctrl::getInstance()->displayErrorMessage(201);}
+    if(cavities_exceeded){
+      _reporter->displayErrorMessage(201, {std::to_string(std::numeric_limits<Cavity::id_type>::max())});
+    }
     auto end = std::chrono::steady_clock::now();
     _data.addTime(std::chrono::duration<double>(end-start).count());
   }
   { // sum total volume
+    Profiler::ScopedStage stage("volume");
     auto start = std::chrono::steady_clock::now();
     _cell.sumVolume(_data.volumes, _data.cavities, _data.analyze_unit_cell);
 
@@ -144,6 +203,7 @@ double calcMolarMass(const std::map<std::string,int>&, const std::unordered_map<
 std::string generateChemicalFormula(const std::map<std::string,int>&, const std::vector<std::string>&);
 
 void Model::prepareVolumeCalc(){
+  Profiler::ScopedStage stage("prepare");
   auto start = std::chrono::steady_clock::now();
   // clear calculation times from previous runs
   _data.elapsed_seconds.clear();
@@ -186,9 +246,10 @@ void Model::prepareVolumeCalc(){
 
 CalcReportBundle Model::generateSurfaceData(){
   // requires volume calculation!
+  Profiler::ScopedStage stage("surface");
   auto start = std::chrono::steady_clock::now();
-  Ctrl::getInstance()->updateStatus("Calculating surface areas...");
-  Ctrl::getInstance()->updateProgressBar(0);
+  _reporter->updateStatus("Calculating surface areas...");
+  _reporter->updateProgressBar(0);
 
   // TODO: make this variable static
   std::vector<std::vector<char>> solid_types =
@@ -197,48 +258,25 @@ CalcReportBundle Model::generateSurfaceData(){
     {0b00001001, 0b00010001},
     {0b00001001} };
 
-  const int total_surfaces = solid_types.size() + 2*_data.cavities.size();
-  auto percentageDone = [](double num, double denom){return int(100*num/denom);};
+  // all surfaces of the structure and of its cavities are computed in a single sweep over the grid.
+  // cavity shell and core surfaces use the types of the probe excluded and probe accessible surfaces
+  const Space::SurfaceSums surfaces = _cell.calcSurfAreas(solid_types, solid_types[2], solid_types[3]);
+  if(_reporter->getAbortFlag()){
+    _data.success = false;
+    return _data;
+  }
 
   // full structure surfaces
-  {
-    std::vector<double> surfaces; // temporary
-    for(size_t i = 0; i < solid_types.size(); ++i){
-      // special case for this set of types, to avoid recalculation
-      if (i == 2 && !optionProbeMode()){
-        surfaces.push_back(surfaces[1]);
-      }
-      else {
-        surfaces.push_back(_cell.calcSurfArea(solid_types[i]));
-      }
-      Ctrl::getInstance()->updateProgressBar(percentageDone(i+1,total_surfaces));
-      // check abort flag
-      if(Ctrl::getInstance()->getAbortFlag()){
-        _data.success = false;
-        return _data;
-      }
-    }
-    // from temporary container to _data
-    _data.surf_vdw = surfaces[0];
-    _data.surf_molecular = surfaces[1];
-    _data.surf_probe_excluded = surfaces[2];
-    _data.surf_probe_accessible = surfaces[3];
-  }
+  _data.surf_vdw = surfaces.totalArea(0);
+  _data.surf_molecular = surfaces.totalArea(1);
+  // without the large probe, the probe excluded surface is the molecular surface
+  _data.surf_probe_excluded = surfaces.totalArea(optionProbeMode()? 2 : 1);
+  _data.surf_probe_accessible = surfaces.totalArea(3);
 
   // cavity surfaces
-  for (size_t i = 0; i < _data.cavities.size(); ++i){
-    Cavity& cav = _data.cavities[i];
-
-    cav.surf_shell = _cell.calcSurfArea(solid_types[2], cav.id, cav.min_index, cav.max_index);
-    Ctrl::getInstance()->updateProgressBar(percentageDone(solid_types.size() + i*2 + 1,total_surfaces));
-
-    cav.surf_core = _cell.calcSurfArea(solid_types[3], cav.id, cav.min_index, cav.max_index);
-    Ctrl::getInstance()->updateProgressBar(percentageDone(solid_types.size() + i*2 + 2,total_surfaces));
-
-    if(Ctrl::getInstance()->getAbortFlag()){
-      _data.success = false;
-      return _data;
-    }
+  for (Cavity& cav : _data.cavities){
+    cav.surf_shell = surfaces.cavityShellArea(cav.id);
+    cav.surf_core = surfaces.cavityCoreArea(cav.id);
   }
 
   auto end = std::chrono::steady_clock::now();
@@ -366,7 +404,8 @@ void Model::defineCell(){
   if(optionAnalyzeUnitCell()){
     unit_cell_limits = {_cart_matrix[0][0], _cart_matrix[1][1], _cart_matrix[2][2]};
   }
-  _cell = Space(_atoms, _data.grid_step, _data.max_depth, optionProbeMode()? getProbeRad2() : getProbeRad1(), optionAnalyzeUnitCell(), unit_cell_limits);
+  _cell = Space(_atoms, _data.grid_step, _data.max_depth, optionProbeMode()? getProbeRad2() : getProbeRad1(), optionAnalyzeUnitCell(), unit_cell_limits, _data.n_threads, _data.sparse_grid, _data.distance_transform);
+  _cell.setReporter(*_reporter);
   return;
 }
 
@@ -395,13 +434,13 @@ bool Model::processUnitCell(){
   */
   double radius_limit = _data.grid_step + _max_atom_radius + 2*( (_data.probe_mode) ? getProbeRad2() : getProbeRad1() );
   if(fileExtension(_data.atom_file_path) == "pdb" && _space_group == ""){
-    Ctrl::getInstance()->displayErrorMessage(111);
+    _reporter->displayErrorMessage(111);
     return false;
   }
 
   for(int i = 0; i < 6; i++){
     if(_cell_param[i] == 0){
-      Ctrl::getInstance()->displayErrorMessage(112);
+      _reporter->displayErrorMessage(112);
       return false;
     }
   }
@@ -429,7 +468,7 @@ bool Model::processUnitCell(){
 bool Model::symmetrizeUnitCell(){
   if(fileExtension(_data.atom_file_path) == "pdb"){
     if(!getSymmetryElements(_space_group, _sym_matrix_XYZ, _sym_matrix_fraction)){
-      Ctrl::getInstance()->displayErrorMessage(113);
+      _reporter->displayErrorMessage(113);
       return false;
     }
   }
@@ -1,6 +1,5 @@
 #include "model.h"
 #include "atom.h"
-#include "controller.h"
 #include "misc.h"
 #include "exception.h"
 #include "importmanager.h"
@@ -28,12 +27,22 @@ struct ElementsFileBundle{ // data bundle for elements file import
 // ELEMENTS FILE IMPORT //
 //////////////////////////
 // TODO: Move to importmanager.h
-ElementsFileBundle extractDataFromElemFile(const std::string& elem_path);
+ElementsFileBundle extractDataFromElemFile(const std::string& elem_path, Reporter&);
+
+std::string Model::getDefaultElemPath(){
+#if defined(_WIN32)
+    std::string sep = "\\";
+#else
+    std::string sep = "/";
+#endif
+
+  return getResourcesDir() + sep + s_elem_file;
+}
 
 // generates three maps for assigning a radius, weight and atomic number respectively, to an element symbol
 // sets the maps to members of the model class
 bool Model::importElemFile(const std::string& elem_path){
-  ElementsFileBundle data = extractDataFromElemFile(elem_path);
+  ElementsFileBundle data = extractDataFromElemFile(elem_path, *_reporter);
   setRadiusMap(data.rad_map);
   _elem_weight = data.weight_map;
   _elem_Z = data.atomic_num_map;
@@ -44,10 +53,10 @@ bool Model::importElemFile(const std::string& elem_path){
 // used for importing only the radius map from the radius file
 // needed for running the app from the command line
 std::unordered_map<std::string, double> Model::extractRadiusMap(const std::string& elem_path){
-  return extractDataFromElemFile(elem_path).rad_map;
+  return extractDataFromElemFile(elem_path, *_reporter).rad_map;
 }
 
-ElementsFileBundle extractDataFromElemFile(const std::string& elem_path){
+ElementsFileBundle extractDataFromElemFile(const std::string& elem_path, Reporter& reporter){
   ElementsFileBundle data;
 
   auto hasCorrectFormat = [](std::vector<std::string> substrings){
@@ -94,9 +103,9 @@ ElementsFileBundle extractDataFromElemFile(const std::string& elem_path){
       }
     }
   }
-  if (invalid_symbol_detected) {Ctrl::getInstance()->displayErrorMessage(106);}
-  if (invalid_radius_value) {Ctrl::getInstance()->displayErrorMessage(107);}
-  if (invalid_weight_value) {Ctrl::getInstance()->displayErrorMessage(108);}
+  if (invalid_symbol_detected) {reporter.displayErrorMessage(106);}
+  if (invalid_radius_value) {reporter.displayErrorMessage(107);}
+  if (invalid_weight_value) {reporter.displayErrorMessage(108);}
   return data;
 }
 
@@ -110,11 +119,11 @@ bool Model::readAtomsFromFile(const std::string& filepath, bool include_hetatm){
   std::vector<Atom> atom_list;
   // XYZ file import
   if (fileExtension(filepath) == "xyz"){
-    atom_list = ImportMngr::readFileXYZ(filepath);
+    atom_list = ImportMngr::readFileXYZ(filepath, _reporter);
   }  
   // PDB file import
   else if (fileExtension(filepath) == "pdb"){
-    const std::pair<std::vector<Atom>,UnitCell> import_data = ImportMngr::readFilePDB(filepath, include_hetatm);
+    const std::pair<std::vector<Atom>,UnitCell> import_data = ImportMngr::readFilePDB(filepath, include_hetatm, _reporter);
     atom_list = import_data.first;
     
     _space_group = import_data.second.space_group;
@@ -125,7 +134,7 @@ bool Model::readAtomsFromFile(const std::string& filepath, bool include_hetatm){
   // CIF file import
   else if (fileExtension(filepath) == "cif"){
     try{
-      const std::pair<std::vector<Atom>,UnitCell> import_data = ImportMngr::readFileCIF(filepath);
+      const std::pair<std::vector<Atom>,UnitCell> import_data = ImportMngr::readFileCIF(filepath, _reporter);
       atom_list = import_data.first;
       _cell_param = import_data.second.parameters;
       _cart_matrix = import_data.second.cart_matrix;
@@ -133,13 +142,13 @@ bool Model::readAtomsFromFile(const std::string& filepath, bool include_hetatm){
       _sym_matrix_fraction = import_data.second.sym_matrix_fraction;
     }
     catch (const ExceptInvalidCellParams& e){
-      Ctrl::getInstance()->displayErrorMessage(112);
+      _reporter->displayErrorMessage(112);
       return false;
     }
   }
   // File extension not supported 
   else {
-    Ctrl::getInstance()->displayErrorMessage(103);
+    _reporter->displayErrorMessage(103);
     return false;
   }
 
@@ -149,7 +158,7 @@ bool Model::readAtomsFromFile(const std::string& filepath, bool include_hetatm){
   
   // If no atom is detected in the input file, the file is deemed invalid
   if (atom_list.empty()){
-    Ctrl::getInstance()->displayErrorMessage(102);
+    _reporter->displayErrorMessage(102);
     return false;
   }
 
@@ -177,6 +186,26 @@ std::vector<std::string> Model::listElementsInStructure(){
   return list;
 }
 
+// lines of the space group file. the file is read once per process, since the calculation of a unit
+// cell may look up its space group many times in a long running process
+static const std::vector<std::string>& spaceGroupFileLines(){
+  static const std::vector<std::string> lines = [](){
+#if defined(_WIN32)
+    std::string sep = "\\";
+#else
+    std::string sep = "/";
+#endif
+    std::vector<std::string> file_lines;
+    std::ifstream sym_file(getResourcesDir() + sep + "space_groups.txt");
+    std::string sym_line;
+    while (getline (sym_file, sym_line)){
+      file_lines.push_back(sym_line);
+    }
+    return file_lines;
+  }();
+  return lines;
+}
+
 // TODO: This function seems misplaced
 bool Model::getSymmetryElements(std::string group, std::vector<int> &sym_matrix_XYZ, std::vector<double> &sym_matrix_fraction){
   for (size_t i = 0; i<group.size(); i++) { // convert space group to upper case chars to compare with the list
@@ -184,17 +213,9 @@ bool Model::getSymmetryElements(std::string group, std::vector<int> &sym_matrix_
   }
   group = "'" + group + "'";
 
-#if defined(_WIN32)
-  std::string sep = "\\";
-#else
-  std::string sep = "/";
-#endif
-
-  std::ifstream sym_file(getResourcesDir() + sep + "space_groups.txt");
-  std::string sym_line;
   bool group_found = 0;
   bool sym_matrix = 0;
-  while (getline (sym_file, sym_line)){
+  for (const std::string& sym_line : spaceGroupFileLines()){
     if(sym_matrix){
       if(sym_line.find("Space group end") != std::string::npos){
         return true; // end function when all symmetry elements of the matching space group are stored in vectors
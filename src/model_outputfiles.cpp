@@ -1,6 +1,5 @@
 #include "model.h"
 #include "atom.h"
-#include "controller.h"
 #include "misc.h"
 #include "container3d.h"
 #include "griddata.h"
@@ -16,7 +15,7 @@
 // RESULT REPORT //
 ///////////////////
 
-std::string makeExportFileName(const std::string, const CalcReportBundle&, const char, const unsigned char=0);
+std::string makeExportFileName(const std::string, const CalcReportBundle&, const char, const size_t=0);
 
 int optimalPrecision(const double value);
 
@@ -44,7 +43,7 @@ void Model::createReport(std::string path){
   output_report << "Source code available at https://github.com/molovol/MoloVol under the MIT licence\n";
   output_report << "Copyright © 2020-2025 Jasmin B. Maglic, Roy Lavendomme\n\n";
   output_report << "MoloVol program: calculation results report\n";
-  output_report << "version: " + Ctrl::getVersion() + "\n\n";
+  output_report << "version: " + getVersion() + "\n\n";
   output_report << "Time of the calculation: " << _time_stamp << "\n";
   output_report << "Duration of the calculation: " << _data.getTime() << " s\n\n";
   output_report << "Structure file analyzed: " << _data.atom_file_path << "\n";
@@ -364,7 +363,7 @@ void Model::writeTotalSurfaceMap(){
 
 void Model::writeTotalSurfaceMap(const std::string file_path){
   // save commonly used variable
-  std::array<unsigned long int,3> n_elements = _cell.getGrid(0).getNumElements();
+  std::array<unsigned long int,3> n_elements = _cell.getGridstepsOnLvl(0);
   double vxl_length = _cell.getVxlSize();
   std::array<double,3> cell_min = _cell.getMin();
   std::array<double,3> origin;
@@ -415,7 +414,7 @@ void Model::writeCavitiesMaps(const std::string file_path){
 
   // loop over each cavity id
   for(size_t id = 0; id < _data.cavities.size(); id++){
-    std::array<unsigned long int,3> n_elements = _cell.getGrid(0).getNumElements();
+    std::array<unsigned long int,3> n_elements = _cell.getGridstepsOnLvl(0);
     start_index = _data.cavities[id].min_index;
     end_index = _data.cavities[id].max_index;
     // increase size of surface map grid by 1 voxel in each direction to avoid having surfaces on the border of the map
@@ -453,11 +452,8 @@ void Model::writeSurfaceMap(const std::string file_path,
                             std::array<unsigned int,3> start_index,
                             std::array<unsigned int,3> end_index,
                             const bool partial_map,
-                            const unsigned char id){
+                            const size_t id){
   bool issue_encountered = false;
-  // assemble data
-  const Container3D<Voxel>* surface_map = &_cell.getGrid(0);
-
   // create map for assigning numbers to types
   const std::map<char,int> typeToNum =
     {{0b00000011, 0},
@@ -508,9 +504,10 @@ void Model::writeSurfaceMap(const std::string file_path,
   for(unsigned long int x = start_index[0]; x < end_index[0]; x++){
     for(unsigned long int y = start_index[1]; y < end_index[1]; y++){
       for(unsigned long int z = start_index[2]; z < end_index[2]; z++){
-        if (typeToNum.count(surface_map->getElement(x,y,z).getType()) != 0){
-          if (partial_map? surface_map->getElement(x,y,z).getID() == _data.cavities[id].id : true){
-            output_file << typeToNum.find(surface_map->getElement(x,y,z).getType())->second;
+        const std::array<unsigned long,3> index = {x,y,z};
+        if (typeToNum.count(_cell.getType(index, 0)) != 0){
+          if (partial_map? _cell.getID(index, 0) == _data.cavities[id].id : true){
+            output_file << typeToNum.find(_cell.getType(index, 0))->second;
           }
           else {
             output_file << 0;
@@ -536,11 +533,11 @@ void Model::writeSurfaceMap(const std::string file_path,
 
   // close the file
   output_file.close();
-  if (issue_encountered) {Ctrl::getInstance()->displayErrorMessage(303);}
+  if (issue_encountered) {_reporter->displayErrorMessage(303);}
 }
 
-const Container3D<Voxel>& Model::getSurfaceData() const {
-  return _cell.getGrid(0);
+const Space& Model::getSurfaceData() const {
+  return _cell;
 }
 
 std::array<double,3> Model::getCellOrigin() const {
@@ -573,7 +570,7 @@ bool fileExists(const std::string&);
 
 std::string rstripZeros(const std::string str);
 
-std::string makeExportFileName(const std::string dir, const CalcReportBundle& data, const char filetype, const unsigned char n_cav){
+std::string makeExportFileName(const std::string dir, const CalcReportBundle& data, const char filetype, const size_t n_cav){
   assert(s_file_descriptor.count(filetype));
   std::string filename = "";
   filename += fileName(data.atom_file_path);
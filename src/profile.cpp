@@ -0,0 +1,118 @@
+#include "profile.h"
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <algorithm> // max
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+ProfileCounts& ProfileCounts::operator+=(const ProfileCounts& other){
+  for (size_t lvl = 0; lvl < s_n_lvls; ++lvl){
+    split_vxls[lvl] += other.split_vxls[lvl];
+  }
+  tree_nodes += other.tree_nodes;
+  shells_scanned += other.shells_scanned;
+  flood_stack_max = (std::max)(flood_stack_max, other.flood_stack_max); // parentheses keep the max macro of windows.h out
+  return *this;
+}
+
+static std::mutex s_profile_mtx;
+static ProfileCounts s_ended_counts; // counters of the threads that have ended
+static std::vector<StageTime> s_stages;
+
+// user and kernel time of all threads of the process
+double processCpuSeconds(){
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)){return 0;}
+  auto seconds = [](const FILETIME& t){
+    return double((uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+  };
+  return seconds(kernel) + seconds(user);
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0){return 0;}
+  auto seconds = [](const timeval& t){return double(t.tv_sec) + double(t.tv_usec) * 1e-6;};
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#endif
+}
+
+void Profiler::enable(const bool state){
+  s_enabled.store(state);
+}
+
+// the counters of a thread are added to the counters of the ended threads when the thread ends
+struct ThreadCounts{
+  ProfileCounts counts;
+
+  ~ThreadCounts(){
+    std::lock_guard<std::mutex> lock(s_profile_mtx);
+    s_ended_counts += counts;
+  }
+};
+
+ProfileCounts& Profiler::threadCounts(){
+  thread_local ThreadCounts local;
+  return local.counts;
+}
+
+void Profiler::reset(){
+  std::lock_guard<std::mutex> lock(s_profile_mtx);
+  s_ended_counts = ProfileCounts();
+  threadCounts() = ProfileCounts();
+  s_stages.clear();
+}
+
+ProfileCounts Profiler::collectCounts(){
+  std::lock_guard<std::mutex> lock(s_profile_mtx);
+  ProfileCounts counts = s_ended_counts;
+  counts += threadCounts();
+  return counts;
+}
+
+std::vector<StageTime> Profiler::collectStages(){
+  std::lock_guard<std::mutex> lock(s_profile_mtx);
+  return s_stages;
+}
+
+void Profiler::addStage(const StageTime& stage){
+  std::lock_guard<std::mutex> lock(s_profile_mtx);
+  s_stages.push_back(stage);
+}
+
+Profiler::ScopedStage::ScopedStage(const std::string& name)
+  : _name(name), _wall_start(std::chrono::steady_clock::now()), _cpu_start(processCpuSeconds()) {}
+
+Profiler::ScopedStage::~ScopedStage(){
+  StageTime stage;
+  stage.name = _name;
+  stage.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _wall_start).count();
+  stage.cpu_seconds = processCpuSeconds() - _cpu_start;
+  addStage(stage);
+}
+
+// the stage names are fixed identifiers, so they need no escaping. the split voxels are listed
+// from level 0 up to the highest level with a split voxel
+std::string Profiler::toJson(const std::vector<StageTime>& stages, const ProfileCounts& counts){
+  std::ostringstream json;
+  json << std::setprecision(9);
+  json << "{\"stages\":[";
+  for (size_t i = 0; i < stages.size(); ++i){
+    json << (i? "," : "") << "{\"name\":\"" << stages[i].name << "\",\"wall_seconds\":" << stages[i].wall_seconds
+      << ",\"cpu_seconds\":" << stages[i].cpu_seconds << "}";
+  }
+  size_t n_lvls = ProfileCounts::s_n_lvls;
+  while (n_lvls > 0 && counts.split_vxls[n_lvls-1] == 0){n_lvls--;}
+  json << "],\"counters\":{\"split_voxels\":[";
+  for (size_t lvl = 0; lvl < n_lvls; ++lvl){
+    json << (lvl? "," : "") << counts.split_vxls[lvl];
+  }
+  json << "],\"tree_nodes\":" << counts.tree_nodes
+    << ",\"shells_scanned\":" << counts.shells_scanned
+    << ",\"flood_fill_stack_max\":" << counts.flood_stack_max << "}}";
+  return json.str();
+}
@@ -0,0 +1,68 @@
+#include "progress.h"
+
+ProgressToken::ProgressToken(){
+  reset();
+}
+
+void ProgressToken::reset(){
+  _aborted.store(false);
+  _stage.store((unsigned char)CalcStage::atoms);
+  for (size_t i = 0; i < s_n_stages; ++i){
+    _work[i].store(0);
+    _done[i].store(0);
+  }
+}
+
+void ProgressToken::requestAbort(){
+  _aborted.store(true);
+}
+
+// the countdown is kept per thread, so that sampling does not write to memory shared between threads
+bool ProgressToken::sampleAbort() const {
+  thread_local unsigned countdown = 0;
+  if (countdown > 0){
+    countdown--;
+    return false;
+  }
+  countdown = s_sample_interval-1;
+  return isAborted();
+}
+
+void ProgressToken::beginStage(const CalcStage stage){
+  _stage.store((unsigned char)stage, std::memory_order_relaxed);
+}
+
+CalcStage ProgressToken::getStage() const {
+  return CalcStage(_stage.load(std::memory_order_relaxed));
+}
+
+void ProgressToken::addWork(const uint64_t units, const CalcStage stage){
+  _work[size_t(stage)].fetch_add(units, std::memory_order_relaxed);
+}
+
+void ProgressToken::addWork(const uint64_t units){
+  addWork(units, getStage());
+}
+
+void ProgressToken::addProgress(const uint64_t units, const CalcStage stage){
+  _done[size_t(stage)].fetch_add(units, std::memory_order_relaxed);
+}
+
+void ProgressToken::addProgress(const uint64_t units){
+  addProgress(units, getStage());
+}
+
+uint64_t ProgressToken::getWork(const CalcStage stage) const {
+  return _work[size_t(stage)].load(std::memory_order_relaxed);
+}
+
+uint64_t ProgressToken::getProgress(const CalcStage stage) const {
+  return _done[size_t(stage)].load(std::memory_order_relaxed);
+}
+
+double ProgressToken::getFraction(const CalcStage stage) const {
+  const uint64_t work = getWork(stage);
+  if (work == 0){return 0;}
+  const uint64_t done = getProgress(stage);
+  return (done >= work)? 1 : double(done)/double(work);
+}
@@ -1,6 +1,5 @@
 #include "render_frame.h"
-#include "container3d.h"
-#include "voxel.h"
+#include "space.h"
 #include "base.h"
 #include "atomtree.h"
 
@@ -84,10 +83,10 @@ RenderFrame::~RenderFrame()
 // PUBLIC METHODS //
 ////////////////////
 
-void RenderFrame::UpdateSurface(const Container3D<Voxel>& surf_data, const std::array<double,3> origin, 
-    const double grid_step, const bool probe_mode, const unsigned char n_cavities){
+void RenderFrame::UpdateSurface(const Space& surf_data, const std::array<double,3> origin, 
+    const double grid_step, const bool probe_mode, const size_t n_cavities){
   // Set up image
-  std::array<unsigned long,3> dims = surf_data.getNumElements();
+  std::array<unsigned long,3> dims = surf_data.getGridstepsOnLvl(0);
 
   imagedata->PrepareForNewData();
   imagedata->SetDimensions(dims[0],dims[1],dims[2]);
@@ -110,7 +109,7 @@ void RenderFrame::UpdateSurface(const Container3D<Voxel>& surf_data, const std::
     for (size_t j = 0; j < dims[1]; ++j) {
       for (size_t k = 0; k < dims[2]; ++k) {
         unsigned char* voxel = static_cast<unsigned char*>(imagedata->GetScalarPointer(i,j,k));
-        *voxel = (unsigned char)typeToNum.find(surf_data.getElement(i,j,k).getType())->second;
+        *voxel = (unsigned char)typeToNum.find(surf_data.getType(std::array<size_t,3>({i,j,k}), 0))->second;
       }
     }
   }
@@ -434,13 +433,13 @@ void RenderFrame::OnButtonClick(wxCommandEvent& event) {
 }
 
 void RenderFrame::OnCavitySelect(wxCommandEvent& event) {
-  auto surf_data = m_parentWindow->getSurfaceData();
+  const Space& surf_data = m_parentWindow->getSurfaceData();
   maskdata->PrepareForNewData();
   
   // Get a vector of selected cavity IDs
   wxArrayInt selection;
   int n_selections = m_cavityList->GetSelections(selection);
-  std::vector<unsigned char> idx_list;
+  std::vector<Cavity::id_type> idx_list;
   for (size_t i = 0; i < n_selections; ++i) {
     idx_list.push_back(selection.Item(i));
   }
@@ -462,7 +461,7 @@ void RenderFrame::OnCavitySelect(wxCommandEvent& event) {
   }
   else {
     // Get size of image data
-    std::array<unsigned long,3> dims = surf_data.getNumElements();
+    std::array<unsigned long,3> dims = surf_data.getGridstepsOnLvl(0);
     maskdata->SetDimensions(dims[0],dims[1],dims[2]);
     maskdata->AllocateScalars(VTK_UNSIGNED_CHAR,1);
 
@@ -471,7 +470,7 @@ void RenderFrame::OnCavitySelect(wxCommandEvent& event) {
         for (size_t k = 0; k < dims[2]; ++k) {
           unsigned char* voxel = static_cast<unsigned char*>(maskdata->GetScalarPointer(i,j,k));
           *voxel = (unsigned char)(
-              std::binary_search(idx_list.begin(), idx_list.end(), surf_data.getElement(i,j,k).getID())? 1 : 0
+              std::binary_search(idx_list.begin(), idx_list.end(), surf_data.getID(std::array<size_t,3>({i,j,k}), 0))? 1 : 0
             );
         }
       }
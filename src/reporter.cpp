@@ -0,0 +1,66 @@
+#include "reporter.h"
+#include <map>
+#include <cassert>
+
+////////////////////
+// ERROR MESSAGES //
+////////////////////
+
+static const std::map<int, std::string> s_error_codes = {
+  {0, "Unidentified error code."}, // no user should ever see this
+  // 1xx: Invalid Input
+  {100, "Import failed!"},
+  {101, "Invalid elements file. Please select a valid file or set radii manually. Atomic weights will be set to 0."},
+  {102, "Invalid structure file. Please select a valid file. You may need to enable the option HETATM for PDB files."},
+  {103, "Invalid file format. Please make sure that the input files have the correct file extensions."},
+  {104, "Invalid probe radius input. The large probe must have a larger radius than the small probe."},
+  {105, "Invalid entry in structure file encountered. Some atoms have not been imported. Please check the format of the input file."},
+  {106, "Invalid element symbol(s) in elements file detected. Some radii may be assigned incorrectly. Please make sure that all element symbols begin with an alphabetic character."},
+  {107, "Invalid radius value in elements file detected. Some radii may be set to 0. Please make sure that all radii are numeric."},
+  {108, "Invalid atomic weight value in elements file detected. Some atomic weights may be set to 0. Please make sure that all atomic weights are numeric."},
+  {109, "Invalid numeric input. Please make sure that all input values have a valid number format."},
+  // 11x: unit cell files
+  {111, "Space group not found. Check the structure file, or untick the Unit Cell Analysis tickbox."},
+  {112, "Invalid unit cell parameters. Check the structure file, or untick the Unit Cell Analysis tickbox."},
+  {113, "Space group or symmetry not found. Check the structure and space group files or untick the Unit Cell Analysis tickbox"},
+  {114, "Invalid ATOM or HETATM line encountered. Import may be incomplete. Check the structure file."},
+  {115, "Invalid option(s). You may have selected an option that is incompatible with the structure file format."},
+  // 2xx: Issue during Calculation
+  {200, "Calculation failed!"},
+  {201, "Total number of cavities (%s) exceeded. Consider changing the probe size. Calculation will proceed."},
+  // 3xx: Issue with Output
+  {300, "Output failed!"},
+  {301, "Data missing to export file. Calculation may be still running or has not been started."},
+  {302, "Invalid output directory. Please select a valid output directory."},
+  {303, "An unidentified issue has been encountered while writing the surface map."},
+  // 9xx: Issues with command line arguments
+  {900, "Command line interface failed!"},
+  {902, "Invalid output display option. At least one parameter belonging to '-o' is invalid and will be ignored."},
+  {903, "Elements file import failed. Calculation aborted."},
+  {904, "Invalid number of threads. Please provide a non-negative number (0 uses all available cores)."},
+  {905, "Invalid profile format. The only supported format is 'json'."},
+  {906, "Invalid job in line %s of the job list: %s."},
+  // 9xx: Required command line arguments missing
+  {910, "Unexpected error. More than three required command line arguments appear to be missing."},
+  {911, "One required command line argument missing. Please provide --%s"},
+  {912, "Two required command line arguments missing. Please provide --%s and --%s"},
+  {913, "Three required command line arguments missing. Please provide --%s, --%s, and --%s"}
+};
+
+std::string Reporter::getErrorMessage(const int error_code, const std::vector<std::string>& str_fill){
+  auto it = s_error_codes.find(error_code);
+  std::string msg = (it == s_error_codes.end())? s_error_codes.find(0)->second : it->second;
+
+  // Substitute place holders
+  size_t i = 0;
+  while (msg.find("%s") != std::string::npos){
+    assert(str_fill.size() > i);
+    msg.replace(msg.find("%s"), 2, i < str_fill.size()? str_fill[i] : "");
+    ++i;
+  }
+  return msg;
+}
+
+void Reporter::displayErrorMessage(const int error_code, const std::vector<std::string>& str_fill){
+  _errors.emplace_back(error_code, getErrorMessage(error_code, str_fill));
+}
@@ -0,0 +1,237 @@
+#include "searchindex.h"
+#include <cmath>
+#include <algorithm> // max_element, swap
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/////////////////////////
+// SEARCH INDEX STRUCT //
+/////////////////////////
+
+// function declarations for functions used in SearchIndex initialisation
+std::vector<std::array<int,3>> logPermutations(const std::array<unsigned int,3>);
+void signCombinations(std::vector<std::array<int,3>>&, std::array<int,3>);
+void signCombinations(std::vector<std::array<int,3>>&, std::array<unsigned int,3>);
+
+// constructors
+SearchIndex::SearchIndex(){}
+
+SearchIndex::SearchIndex(const double r_probe, const double grid_size, const unsigned int max_depth){
+  _safe_lim = std::vector<unsigned int>(max_depth+1);
+  _upp_lim = std::vector<unsigned int>(max_depth+1);
+  for (unsigned int lvl = 0; lvl <= max_depth; ++lvl){
+    // maximum distance between neighbour voxels that need to be assessed (in units of voxel side length at lvl)
+    double max_dist = r_probe/(grid_size*std::pow(2,lvl)) + std::sqrt(2)/4;
+    // voxel radius in units of voxel side length at current lvl
+    double vxl_radius = std::sqrt(3) * (1-1/std::pow(2,lvl));
+    // squared max distance between neighbours, where voxels do not have to be split
+    _safe_lim[lvl] = (0 > max_dist - 2*vxl_radius)? 0 : std::pow( max_dist - (2*vxl_radius) , 2);
+    // squared max distance between neighbours, that need to be assessed
+    _upp_lim[lvl] = std::pow( max_dist + 2*vxl_radius , 2);
+  }
+  unsigned int max_element = *std::max_element(_upp_lim.begin(), _upp_lim.end());
+  _index_list = getShells(max_element);
+}
+
+// access
+const std::vector<std::array<int,3>>& SearchIndex::operator[](unsigned int i){
+  return (*_index_list)[i];
+}
+
+unsigned int SearchIndex::getUppLim(unsigned int lvl){
+  return _upp_lim[lvl];
+}
+
+unsigned int SearchIndex::getSafeLim(unsigned int lvl){
+  return _safe_lim[lvl];
+}
+
+// initialisation of indices
+SearchIndex::Shells SearchIndex::computeIndices(unsigned int upp_lim){
+  Shells search_indices = Shells(upp_lim+1);
+  // go through all combinations of three integers x <= y <= z whose squares add up to at most upp_lim.
+  // within each shell, the combinations are ordered by x and then by y
+  for (unsigned long x = 0; 3*x*x <= upp_lim; x++){
+    for (unsigned long y = x; x*x + 2*y*y <= upp_lim; y++){
+      for (unsigned long z = y; x*x + y*y + z*z <= upp_lim; z++){
+        // get all sign combinations for each integer combination
+        std::vector<std::array<int,3>> temp = logPermutations({unsigned(x), unsigned(y), unsigned(z)});
+        std::vector<std::array<int,3>>& shell = search_indices[x*x + y*y + z*z];
+        shell.insert(std::end(shell), std::begin(temp), std::end(temp));
+      }
+    }
+  }
+  return search_indices;
+}
+
+SearchIndex::Shells SearchIndex::computeIndices(unsigned int upp_lim, const bool include_zero){
+  Shells indices = computeIndices(upp_lim);
+  if (!include_zero){
+    indices.erase(indices.begin());
+  }
+  return indices;
+}
+
+// given an array of size three, return all permutations of those three numbers
+std::vector<std::array<int,3>> logPermutations(const std::array<unsigned int,3> inp_arr){
+  std::vector<std::array<int,3>> list;
+  signCombinations(list, inp_arr); // initial order
+  for (int i = 0; i < 2; i++){
+    for (int j = i+1; j < ((inp_arr[1]==inp_arr[2])? 2 : 3); j++){
+      std::array<unsigned int,3> arr = inp_arr;
+      if (arr[i] != arr[j]){ // if i and j are different, swap and store
+        std::swap(arr[i], arr[j]);
+        signCombinations(list, arr);
+        if (i!=1 && arr[1]!=arr[2]){ // if 1 and 2 are different, swap and store
+          std::swap(arr[1], arr[2]);
+          signCombinations(list, arr);
+        }
+      }
+    }
+  }
+  return list;
+}
+
+// to a vector, append all sign combinations of the number in an array of size 3
+void signCombinations(std::vector<std::array<int,3>>& list, std::array<int,3> arr){
+  // following two lines check whether any element is zero
+  for (int sign = 0; sign < ((arr[2]==0)? 4 : 8); sign += ((arr[0]==0)? 2 : 1)){ // loop over sign combinations
+    if (arr[1]==0 && sign%4 > 1){continue;} // skip if middle element is 0
+    list.push_back({
+      (sign & 1)? -arr[0] : arr[0],
+      (sign & 2)? -arr[1] : arr[1],
+      (sign & 4)? -arr[2] : arr[2]
+    });
+  }
+}
+
+void signCombinations(std::vector<std::array<int,3>>& list, std::array<unsigned int,3> inp_arr){
+  std::array<int,3> arr;
+  for (char i = 0; i < 3; i++){arr[i] = int(inp_arr[i]);}
+  signCombinations(list, arr);
+}
+
+/////////////////
+// SHELL CACHE //
+/////////////////
+
+static std::mutex s_cache_mtx;
+static std::shared_ptr<const SearchIndex::Shells> s_cached_shells;
+static std::string s_cache_dir;
+
+void SearchIndex::setCacheDir(const std::string& dir){
+  std::lock_guard<std::mutex> lock(s_cache_mtx);
+  s_cache_dir = dir;
+}
+
+// the shells up to a smaller limit are the first shells of a larger limit, so the largest shells
+// computed so far serve every calculation that needs fewer shells
+std::shared_ptr<const SearchIndex::Shells> SearchIndex::getShells(const unsigned int upp_lim){
+  std::lock_guard<std::mutex> lock(s_cache_mtx);
+  if (s_cached_shells && s_cached_shells->size() > upp_lim){return s_cached_shells;}
+
+  std::string path;
+  if (!s_cache_dir.empty()){
+    path = (std::filesystem::path(s_cache_dir) / ("searchindex_" + std::to_string(upp_lim) + ".bin")).string();
+  }
+  auto shells = std::make_shared<Shells>();
+  if (path.empty() || !readShells(path, upp_lim, *shells)){
+    *shells = SearchIndex().computeIndices(upp_lim);
+    if (!path.empty()){
+      std::error_code ec; // the cache is optional, a directory that cannot be created is skipped
+      std::filesystem::create_directories(s_cache_dir, ec);
+      writeShells(path, *shells);
+    }
+  }
+  s_cached_shells = shells;
+  return s_cached_shells;
+}
+
+// file layout: magic number, format version and number of shells, followed by the number of indices
+// and the indices of each shell. the integers are stored in the byte order of the machine, files
+// written on a machine with a different byte order fail the check of the magic number
+static constexpr uint32_t s_file_magic = 0x4D565349;
+static constexpr uint32_t s_file_version = 1;
+
+bool SearchIndex::readShells(const std::string& path, const unsigned int upp_lim, Shells& shells){
+  std::ifstream file(path, std::ios::binary);
+  if (!file){return false;}
+  auto read = [&file](uint32_t& value){
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return bool(file);
+  };
+  uint32_t magic, version, n_shells;
+  if (!read(magic) || !read(version) || !read(n_shells)){return false;}
+  if (magic != s_file_magic || version != s_file_version || n_shells != uint64_t(upp_lim)+1){return false;}
+
+  shells.assign(n_shells, {});
+  for (uint32_t n = 0; n < n_shells; n++){
+    uint32_t n_indices;
+    if (!read(n_indices)){return false;}
+    // no shell holds more indices than there are points with |x|,|y| <= sqrt(n) and two values of z
+    const uint64_t max_abs = std::sqrt(double(n)) + 1;
+    if (n_indices > 2 * (2*max_abs+1) * (2*max_abs+1)){return false;}
+    shells[n].resize(n_indices);
+    file.read(reinterpret_cast<char*>(shells[n].data()), n_indices * sizeof(std::array<int,3>));
+    if (!file){return false;}
+    for (const std::array<int,3>& index : shells[n]){
+      if (uint64_t(int64_t(index[0])*index[0] + int64_t(index[1])*index[1] + int64_t(index[2])*index[2]) != n){return false;}
+    }
+  }
+  return file.peek() == EOF;
+}
+
+// name of a temporary file next to the path, which no other process or thread uses. several processes
+// may share a cache directory and write the same file at the same time
+static std::string uniqueTmpPath(const std::string& path){
+#if defined(_WIN32)
+  const long pid = _getpid();
+#else
+  const long pid = getpid();
+#endif
+  thread_local std::mt19937_64 rng(std::random_device{}());
+  std::ostringstream tmp_path;
+  tmp_path << path << "." << pid << "." << std::hex << rng() << ".tmp";
+  return tmp_path.str();
+}
+
+// writes to a temporary file first, so that other processes never read an incomplete file
+bool SearchIndex::writeShells(const std::string& path, const Shells& shells){
+  const std::string tmp_path = uniqueTmpPath(path);
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file){return false;}
+    auto write = [&file](const uint32_t value){
+      file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    write(s_file_magic);
+    write(s_file_version);
+    write(shells.size());
+    for (const std::vector<std::array<int,3>>& shell : shells){
+      write(shell.size());
+      file.write(reinterpret_cast<const char*>(shell.data()), shell.size() * sizeof(std::array<int,3>));
+    }
+    if (!file){
+      file.close();
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec){
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
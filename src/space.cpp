@@ -4,19 +4,25 @@
 #include "atomtree.h"
 #include "misc.h"
 #include "exception.h"
-#include "controller.h"
+#include "tiling.h"
+#include "profile.h"
 #include <cmath>
 #include <cassert>
 #include <stdexcept>
 #include <algorithm> // find
 #include <numeric> // accumulate
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+#include <optional>
+#include <bit> // countr_zero
 
 /////////////////
 // CONSTRUCTOR //
 /////////////////
 
-Space::Space(std::vector<Atom> &atoms, const double bot_lvl_vxl_dist, const int depth, const double r_probe, const bool unit_cell_option, const std::array<double,3> unit_cell_axes)
-  :_grid_size(bot_lvl_vxl_dist), _max_depth(depth), _unit_cell_limits(unit_cell_axes), _unit_cell(unit_cell_option){
+Space::Space(std::vector<Atom> &atoms, const double bot_lvl_vxl_dist, const int depth, const double r_probe, const bool unit_cell_option, const std::array<double,3> unit_cell_axes, const unsigned n_threads, const bool sparse, const bool distance_transform)
+  :_grid_size(bot_lvl_vxl_dist), _max_depth(depth), _unit_cell_limits(unit_cell_axes), _unit_cell(unit_cell_option), _n_threads(n_threads), _sparse(sparse), _distance_transform(distance_transform){
   setBoundaries(atoms,r_probe+2*bot_lvl_vxl_dist);
   initGrid();
 }
@@ -87,16 +93,30 @@ void Space::setBoundaries(const std::vector<Atom> &atoms, const double add_space
 // 3D grid (in form of a 1D vector) that contains all top level voxels.
 void Space::initGrid(){
   _grid.clear();
+  _ids.clear();
+  _wide_ids.clear();
   // determine how many top lvl voxels in each direction are needed
-  std::array<unsigned long,3> n_top_lvl_vxl;
+  std::array<unsigned long,3>& n_top_lvl_vxl = _n_top_vxl;
   for (int dim = 0; dim < 3; dim++){
     n_top_lvl_vxl[dim] = std::ceil (std::ceil( (getSize())[dim] / _grid_size ) / std::pow(2,_max_depth) );
   }
+  _lvl_constants.clear();
+  for (int lvl = 0; lvl <= _max_depth; ++lvl){
+    LevelConstants constants;
+    constants.edge = _grid_size * std::pow(2,lvl);
+    constants.radius = 0.86602540378 * _grid_size * (std::pow(2,lvl) - 1);
+    constants.n_bot_lvl_vxl = std::pow(8,lvl);
+    constants.n_vxl = getGridstepsOnLvl(lvl);
+    _lvl_constants.push_back(constants);
+  }
+  if (_sparse){
+    _sparse_grid = SparseGrid(n_top_lvl_vxl, _max_depth);
+    return;
+  }
   // initialise 3d tensors for each octree level
   for (int lvl = 0; lvl <= _max_depth; ++lvl){
-    _grid.push_back(Container3D<Voxel>( n_top_lvl_vxl[0]*pow(2,_max_depth-lvl),
-                                        n_top_lvl_vxl[1]*pow(2,_max_depth-lvl),
-                                        n_top_lvl_vxl[2]*pow(2,_max_depth-lvl)));
+    _grid.push_back(Plane<Voxel>(getGridstepsOnLvl(lvl), MortonLayout(_max_depth-lvl)));
+    _ids.push_back(Plane<unsigned char>(getGridstepsOnLvl(lvl), MortonLayout(_max_depth-lvl)));
   }
 }
 
@@ -111,55 +131,133 @@ void Space::assignTypeInGrid(std::vector<Atom>& atomlist, std::vector<Cavity>& c
   if (probe_mode){
     // first run algorithm with the larger probe to exclude most voxels - "masking mode"
     Voxel::storeProbe(r_probe2, true);
-    Ctrl::getInstance()->updateStatus("Blocking off cavities with large probe...");
+    _reporter->updateStatus("Blocking off cavities with large probe...");
+    Profiler::ScopedStage stage("mask");
+    _progress->beginStage(CalcStage::atoms);
     assignAtomVsCore();
+    _progress->beginStage(CalcStage::shell);
     assignShellVsVoid();
   }
 
-  Ctrl::getInstance()->updateStatus(std::string("Probing space") + (probe_mode? " with small probe..." : "..."));
+  _reporter->updateStatus(std::string("Probing space") + (probe_mode? " with small probe..." : "..."));
   Voxel::storeProbe(r_probe1, false);
-  assignAtomVsCore();
+  {
+    Profiler::ScopedStage stage("atoms");
+    _progress->beginStage(CalcStage::atoms);
+    assignAtomVsCore();
+  }
 
-  Ctrl::getInstance()->updateStatus("Identifying cavities...");
-  try{identifyCavities(cavities, probe_mode);}
-  catch (const std::overflow_error& e){cavities_exceeded = true;}
+  _reporter->updateStatus("Identifying cavities...");
+  {
+    Profiler::ScopedStage stage("cavities");
+    _progress->beginStage(CalcStage::cavities);
+    try{identifyCavities(cavities, probe_mode);}
+    catch (const std::overflow_error& e){cavities_exceeded = true;}
+  }
 
-  Ctrl::getInstance()->updateStatus("Searching inaccessible areas...");
+  _reporter->updateStatus("Searching inaccessible areas...");
+  Profiler::ScopedStage stage("shell");
+  _progress->beginStage(CalcStage::shell);
   assignShellVsVoid();
 }
 
 void Space::assignAtomVsCore(){
-  if (Ctrl::getInstance()->getAbortFlag()){return;}
+  if (_progress->isAborted()){return;}
+  if (TileScheduler::resolveNumThreads(_n_threads) > 1){
+    assignAtomVsCoreParallel();
+    return;
+  }
   // calculate position of first voxel
   const std::array<double,3> vxl_origin = getOrigin();
   // calculate side length of top level voxel
-  const double vxl_dist = _grid_size * pow(2,_max_depth);
+  const double vxl_dist = getLevelConstants(_max_depth).edge;
   std::array<double,3> vxl_pos;
   std::array<unsigned,3> top_lvl_index;
+  _progress->addWork(getGridsteps()[0]);
   for(top_lvl_index[0] = 0; top_lvl_index[0] < getGridsteps()[0]; top_lvl_index[0]++){
-    Ctrl::getInstance()->updateCalculationStatus();
+    _reporter->updateCalculationStatus();
     vxl_pos[0] = vxl_origin[0] + vxl_dist * (0.5 + top_lvl_index[0]);
     for(top_lvl_index[1] = 0; top_lvl_index[1] < getGridsteps()[1]; top_lvl_index[1]++){
       vxl_pos[1] = vxl_origin[1] + vxl_dist * (0.5 + top_lvl_index[1]);
       for(top_lvl_index[2] = 0; top_lvl_index[2] < getGridsteps()[2]; top_lvl_index[2]++){
         vxl_pos[2] = vxl_origin[2] + vxl_dist * (0.5 + top_lvl_index[2]);
         // voxel position is deliberately not stored in voxel object to reduce memory cost
-        if (Ctrl::getInstance()->getAbortFlag()){return;}
+        if (_progress->isAborted()){return;}
         getTopVxl(top_lvl_index).evalRelationToAtoms(top_lvl_index, vxl_pos, _max_depth);
       }
     }
-    Ctrl::getInstance()->updateProgressBar(int(100*(double(top_lvl_index[0])+1)/double(getGridsteps()[0])));
+    _progress->addProgress();
+    _reporter->updateProgressBar(int(100*(double(top_lvl_index[0])+1)/double(getGridsteps()[0])));
   }
 }
 
+// same as assignAtomVsCore() but the top level voxels are processed by several threads.
+// each top level voxel only writes into its own subtree, so the result does not depend on
+// the order in which the voxels are processed
+void Space::assignAtomVsCoreParallel(){
+  const std::array<double,3> vxl_origin = getOrigin();
+  const double vxl_dist = getLevelConstants(_max_depth).edge;
+  forEachTopVxlParallel([&](const std::array<unsigned,3>& top_lvl_index){
+    std::array<double,3> vxl_pos;
+    for (char dim = 0; dim < 3; ++dim){
+      vxl_pos[dim] = vxl_origin[dim] + vxl_dist * (0.5 + top_lvl_index[dim]);
+    }
+    getTopVxl(top_lvl_index).evalRelationToAtoms(top_lvl_index, vxl_pos, _max_depth);
+  });
+}
+
+// splits the top level voxels into tiles that are distributed among the worker threads
+void Space::forEachTopVxlParallel(const std::function<void(const std::array<unsigned,3>&)>& func){
+  // tiles of 2x2x2 top level voxels are small enough to balance the load between threads
+  // and large enough to keep the scheduling overhead low
+  TileScheduler scheduler(getGridstepsOnLvl<unsigned>(_max_depth), 2, _n_threads);
+  runTilesInParallel(scheduler, [&](const TileScheduler::Tile& tile){
+    std::array<unsigned,3> top_lvl_index;
+    for(top_lvl_index[0] = tile.start[0]; top_lvl_index[0] < tile.end[0]; top_lvl_index[0]++){
+      for(top_lvl_index[1] = tile.start[1]; top_lvl_index[1] < tile.end[1]; top_lvl_index[1]++){
+        for(top_lvl_index[2] = tile.start[2]; top_lvl_index[2] < tile.end[2]; top_lvl_index[2]++){
+          if (_progress->isAborted()){return;}
+          func(top_lvl_index);
+        }
+      }
+    }
+  });
+}
+
+// runs the scheduler and reports the progress of the calculation
+void Space::runTilesInParallel(TileScheduler& scheduler, const std::function<void(const TileScheduler::Tile&)>& func){
+  int last_percentage = -1;
+  _progress->addWork(scheduler.size());
+  scheduler.run(
+    [&](const TileScheduler::Tile& tile, const unsigned){
+      func(tile);
+      _progress->addProgress();
+    },
+    // only called on the thread that started the scheduler, so the reporter is never called concurrently
+    [&](const double fraction){
+      const int percentage = int(100*fraction);
+      if (percentage != last_percentage){
+        last_percentage = percentage;
+        _reporter->updateCalculationStatus();
+        _reporter->updateProgressBar(percentage);
+      }
+      return !_progress->isAborted();
+    });
+}
+
 void Space::identifyCavities(std::vector<Cavity>& cavities, const bool cavity_types){
-  if (Ctrl::getInstance()->getAbortFlag()){return;}
+  if (_progress->isAborted()){return;}
+  if (TileScheduler::resolveNumThreads(_n_threads) > 1){
+    identifyCavitiesParallel(cavities, cavity_types);
+    return;
+  }
   std::array<unsigned int,3> vxl_index;
-  unsigned char id = 1;
+  Cavity::id_type id = 1;
+  _progress->addWork(getGridsteps()[0]);
   for(vxl_index[0] = 0; vxl_index[0] < getGridsteps()[0]; vxl_index[0]++){
     for(vxl_index[1] = 0; vxl_index[1] < getGridsteps()[1]; vxl_index[1]++){
       for(vxl_index[2] = 0; vxl_index[2] < getGridsteps()[2]; vxl_index[2]++){
-        if (Ctrl::getInstance()->getAbortFlag()){return;}
+        if (_progress->isAborted()){return;}
         try{
           descendToCore(cavities, id,vxl_index,getMaxDepth(),cavity_types); // id gets iterated inside this function
         }
@@ -168,18 +266,22 @@ void Space::identifyCavities(std::vector<Cavity>& cavities, const bool cavity_ty
         }
       }
     }
-    Ctrl::getInstance()->updateProgressBar(int(100*(double(vxl_index[0])+1)/double(getGridsteps()[0])));
+    _progress->addProgress();
+    _reporter->updateProgressBar(int(100*(double(vxl_index[0])+1)/double(getGridsteps()[0])));
   }
 }
 
 // this function finds the lowest level core voxel. this voxel becomes the entry point
 // for the flood fill
-void Space::descendToCore(std::vector<Cavity>& cavities, unsigned char& id, const std::array<unsigned,3> index, int lvl, const bool cavity_types){
+void Space::descendToCore(std::vector<Cavity>& cavities, Cavity::id_type& id, const std::array<unsigned,3> index, int lvl, const bool cavity_types){
   Voxel& vxl = getVxlFromGrid(index,lvl);
   if (!vxl.isCore()){return;}
   if (!vxl.hasSubvoxel()){
+    if (getID(index,lvl)){return;}
+    // the id no longer fits into the voxel
+    if (id > std::numeric_limits<unsigned char>::max()){enableWideIDs();}
     if(vxl.floodFill(cavities, id, index, lvl, cavity_types)){
-      if (id == 0b11111111){
+      if (id == std::numeric_limits<Cavity::id_type>::max()){
         throw std::overflow_error("Too many isolated cavities detected!");
       }
       id++;
@@ -193,7 +295,7 @@ void Space::descendToCore(std::vector<Cavity>& cavities, unsigned char& id, cons
         subindex[1] = index[1]*2 + j;
         for (char k = 0; k < 2; ++k){
           subindex[2] = index[2]*2 + k;
-          if (Ctrl::getInstance()->getAbortFlag()){return;}
+          if (_progress->isAborted()){return;}
           try {descendToCore(cavities, id, subindex, lvl-1, cavity_types);}
           catch (const std::overflow_error& e){throw;}
         }
@@ -203,30 +305,113 @@ void Space::descendToCore(std::vector<Cavity>& cavities, unsigned char& id, cons
 }
 
 void Space::assignShellVsVoid(){
-  if (Ctrl::getInstance()->getAbortFlag()){return;}
+  if (_progress->isAborted()){return;}
+  // the neighbour search reads the core bits from a compact copy in row major order, which is
+  // faster than looking up neighbours in the Morton ordered planes or in the sparse grid
+  CoreSnapshot snapshot = snapshotCoreBits();
+  Voxel::setCoreSnapshot(&snapshot);
+  // the distance transform costs a few passes over the snapshot, but for large probes most voxels
+  // then skip their neighbour search entirely
+  std::optional<CoreDistances> distances;
+  if (_distance_transform){
+    distances.emplace(snapshot);
+    Voxel::setCoreDistances(&*distances);
+  }
+  try {
+    if (TileScheduler::resolveNumThreads(_n_threads) > 1){assignShellVsVoidParallel();}
+    else {assignShellVsVoidSerial();}
+  }
+  catch (...) {
+    Voxel::setCoreSnapshot(nullptr);
+    Voxel::setCoreDistances(nullptr);
+    throw;
+  }
+  Voxel::setCoreSnapshot(nullptr);
+  Voxel::setCoreDistances(nullptr);
+}
+
+void Space::assignShellVsVoidSerial(){
   std::array<unsigned int,3> vxl_index;
+  _progress->addWork(getGridsteps()[0]);
   for(vxl_index[0] = 0; vxl_index[0] < getGridsteps()[0]; vxl_index[0]++){
-    Ctrl::getInstance()->updateCalculationStatus();
+    _reporter->updateCalculationStatus();
     for(vxl_index[1] = 0; vxl_index[1] < getGridsteps()[1]; vxl_index[1]++){
       for(vxl_index[2] = 0; vxl_index[2] < getGridsteps()[2]; vxl_index[2]++){
-        if (Ctrl::getInstance()->getAbortFlag()){return;}
+        if (_progress->isAborted()){return;}
         getTopVxl(vxl_index).evalRelationToVoxels(vxl_index, _max_depth);
       }
     }
-    Ctrl::getInstance()->updateProgressBar(int(100*(double(vxl_index[0])+1)/double(getGridsteps()[0])));
+    _progress->addProgress();
+    _reporter->updateProgressBar(int(100*(double(vxl_index[0])+1)/double(getGridsteps()[0])));
+  }
+}
+
+// same as assignShellVsVoidSerial() but the top level voxels are processed by several threads.
+// voxels look up the types of their neighbours, which may be changed concurrently by other
+// threads. the neighbour search only reads from the core snapshot, so this is bit-identical
+// to the serial evaluation
+void Space::assignShellVsVoidParallel(){
+  forEachTopVxlParallel([&](const std::array<unsigned,3>& vxl_index){
+    getTopVxl(vxl_index).evalRelationToVoxels(vxl_index, _max_depth);
+  });
+}
+
+// copies the core bits of all voxels. the core bits are never changed during the shell vs void
+// evaluation, so the copy stays valid for the whole pass
+CoreSnapshot Space::snapshotCoreBits(){
+  std::vector<std::array<unsigned long,3>> n_vxl;
+  for (int lvl = 0; lvl <= _max_depth; ++lvl){
+    n_vxl.push_back(getGridstepsOnLvl(lvl));
+  }
+  CoreSnapshot snapshot(n_vxl, Voxel::getCoreBit());
+  for (int lvl = 0; lvl <= _max_depth; ++lvl){
+    std::vector<Voxel> row(n_vxl[lvl][0]);
+    for (unsigned z = 0; z < n_vxl[lvl][2]; ++z){
+      for (unsigned y = 0; y < n_vxl[lvl][1]; ++y){
+        readRow(lvl, y, z, 0, n_vxl[lvl][0], row.data(), nullptr);
+        for (unsigned long x = 0; x < row.size(); ++x){
+          snapshot.setType(lvl, (z * n_vxl[lvl][1] + y) * n_vxl[lvl][0] + x, row[x].getType());
+        }
+      }
+    }
+  }
+  return snapshot;
+}
+
+// moves the cavity ids from the voxels into separate planes that can hold larger ids. this is
+// only done once more than 255 cavities have been found, to save memory in all other cases
+void Space::enableWideIDs(){
+  if (hasWideIDs() || _sparse){return;} // the sparse grid always stores wide ids
+  for (int lvl = 0; lvl <= _max_depth; ++lvl){
+    _wide_ids.push_back(Plane<Cavity::id_type>(getGridstepsOnLvl(lvl), MortonLayout(_max_depth-lvl)));
+    for (unsigned long i = 0; i < totalVxlOnLvl(lvl); ++i){
+      _wide_ids[lvl].getElement(i) = _ids[lvl].getElement(i);
+    }
+    _ids[lvl] = Plane<unsigned char>(); // free each narrow plane right away
   }
+  _ids.clear();
 }
 
+template <typename ID>
+void tallyPlanes(const Space&, const int, const std::array<unsigned,3>&, const std::array<unsigned,3>&,
+    std::map<char,double>&,
+    std::map<Cavity::id_type,double>&,
+    std::map<Cavity::id_type,double>&,
+    std::map<Cavity::id_type,std::array<unsigned,3>>&,
+    std::map<Cavity::id_type,std::array<unsigned,3>>&);
+
 void Space::sumVolume(std::map<char,double>& volumes, std::vector<Cavity>& cavities, const bool unit_cell){
+  _progress->beginStage(CalcStage::volume);
+  _progress->addWork(1);
   // clear all output variables
   volumes.clear();
   // create maps used for tallying voxels
   std::map<char, double> type_tally;
-  std::map<unsigned char, double> id_core_tally;
-  std::map<unsigned char, double> id_shell_tally;
+  std::map<Cavity::id_type, double> id_core_tally;
+  std::map<Cavity::id_type, double> id_shell_tally;
   // contain the boundaries in which all voxels of a given ID are contained
-  std::map<unsigned char, std::array<unsigned,3>> id_min;
-  std::map<unsigned char, std::array<unsigned,3>> id_max;
+  std::map<Cavity::id_type, std::array<unsigned,3>> id_min;
+  std::map<Cavity::id_type, std::array<unsigned,3>> id_max;
 
   if(unit_cell){
     setUnitCellIndexes();
@@ -237,14 +422,23 @@ void Space::sumVolume(std::map<char,double>& volumes, std::vector<Cavity>& cavit
   std::array<unsigned,3> end_index = unit_cell? _unit_cell_end_index : getGridstepsOnLvl<unsigned>(tally_lvl);
 
   // count bottom level voxels per type
-  std::array<unsigned int,3> vxl_index;
-  for (vxl_index[0] = start_index[0]; vxl_index[0] < end_index[0]; vxl_index[0]++){
-    for (vxl_index[1] = start_index[1]; vxl_index[1] < end_index[1]; vxl_index[1]++){
-      for (vxl_index[2] = start_index[2]; vxl_index[2] < end_index[2]; vxl_index[2]++){
-        getVxlFromGrid(vxl_index, tally_lvl).tallyVoxelsOfType(type_tally, id_core_tally, id_shell_tally, id_min, id_max, vxl_index, tally_lvl);
+  if (_sparse){
+    // the sparse grid has no planes to stream through, so the voxels are descended one by one
+    std::array<unsigned int,3> vxl_index;
+    for (vxl_index[0] = start_index[0]; vxl_index[0] < end_index[0]; vxl_index[0]++){
+      for (vxl_index[1] = start_index[1]; vxl_index[1] < end_index[1]; vxl_index[1]++){
+        for (vxl_index[2] = start_index[2]; vxl_index[2] < end_index[2]; vxl_index[2]++){
+          getVxlFromGrid(vxl_index, tally_lvl).tallyVoxelsOfType(type_tally, id_core_tally, id_shell_tally, id_min, id_max, vxl_index, tally_lvl);
+        }
       }
     }
   }
+  else if (hasWideIDs()){
+    tallyPlanes<Cavity::id_type>(*this, tally_lvl, start_index, end_index, type_tally, id_core_tally, id_shell_tally, id_min, id_max);
+  }
+  else {
+    tallyPlanes<unsigned char>(*this, tally_lvl, start_index, end_index, type_tally, id_core_tally, id_shell_tally, id_min, id_max);
+  }
 
   if(unit_cell){
     std::array<unsigned int,3> bot_lvl_index;
@@ -309,6 +503,84 @@ void Space::sumVolume(std::map<char,double>& volumes, std::vector<Cavity>& cavit
       cavities.erase(it--);
     }
   }
+  _progress->addProgress();
+}
+
+// tallies the voxels in range with the same result as Voxel::tallyVoxelsOfType, but streams through the
+// planes level by level instead of descending into every voxel. a voxel is counted, if it is not mixed and
+// it is either on the top level or its parent is mixed. the counts are integers, which are added to the maps
+// at the end. the planes are read in memory order, the xyz index is only computed for counted voxels
+template <typename ID>
+void tallyPlanes(const Space& cell, const int top_lvl, const std::array<unsigned,3>& start_index, const std::array<unsigned,3>& end_index,
+    std::map<char,double>& type_tally,
+    std::map<Cavity::id_type,double>& id_core_tally,
+    std::map<Cavity::id_type,double>& id_shell_tally,
+    std::map<Cavity::id_type,std::array<unsigned,3>>& id_min,
+    std::map<Cavity::id_type,std::array<unsigned,3>>& id_max)
+{
+  const size_t n_ids = size_t(std::numeric_limits<ID>::max()) + 1;
+  std::array<uint64_t,256> type_count;
+  type_count.fill(0);
+  std::vector<uint64_t> core_count(n_ids, 0);
+  std::vector<uint64_t> shell_count(n_ids, 0);
+  const unsigned no_min = std::numeric_limits<unsigned>::max();
+  std::vector<std::array<unsigned,3>> min_index(n_ids, std::array<unsigned,3>({no_min, no_min, no_min}));
+  std::vector<std::array<unsigned,3>> max_index(n_ids, std::array<unsigned,3>({0, 0, 0}));
+  std::vector<bool> found(n_ids, false);
+
+  for (int lvl = top_lvl; lvl >= 0; --lvl){
+    const Voxel* types = cell.getTypePlane(lvl);
+    const Voxel* parent_types = lvl < top_lvl? cell.getTypePlane(lvl+1) : nullptr;
+    const ID* ids;
+    if constexpr (std::is_same_v<ID, unsigned char>){ids = cell.getIDPlane(lvl);}
+    else {ids = cell.getWideIDPlane(lvl);}
+    const int n_sublvl = top_lvl - lvl;
+    const uint64_t weight = uint64_t(1) << (3*lvl);
+    const unsigned edge = pow2(lvl);
+
+    for (unsigned long pos = 0; pos < cell.totalVxlOnLvl(lvl); ++pos){
+      const char type = types[pos].getType();
+      if (readBit(type,7)){continue;}
+      if (parent_types && !readBit(parent_types[pos/8].getType(),7)){continue;}
+      const std::array<unsigned long,3> coord = cell.getPlaneCoord(lvl, pos);
+      std::array<unsigned,3> index;
+      bool in_range = true;
+      for (char i = 0; i < 3; i++){
+        index[i] = coord[i];
+        in_range &= index[i] >= start_index[i] << n_sublvl && index[i] < end_index[i] << n_sublvl;
+      }
+      if (!in_range){continue;}
+      const ID id = ids[pos];
+      type_count[(unsigned char)type] += weight;
+      if(type == 0b00001001){
+        core_count[id] += weight;
+      }
+      else if(type == 0b00010001){
+        shell_count[id] += weight;
+      }
+      // localise cavities
+      found[id] = true;
+      for (char i = 0; i < 3; i++){
+        min_index[id][i] = std::min(min_index[id][i], index[i]*edge);
+        max_index[id][i] = std::max(max_index[id][i], ((index[i]+1)*edge)-1);
+      }
+    }
+  }
+
+  for (unsigned type = 0; type < type_count.size(); ++type){
+    if (type_count[type]){type_tally[char(type)] += type_count[type];}
+  }
+  for (size_t id = 0; id < n_ids; ++id){
+    if (!found[id]){continue;}
+    if (core_count[id]){id_core_tally[id] += core_count[id];}
+    if (shell_count[id]){id_shell_tally[id] += shell_count[id];}
+    if (id_min.count(id) == 0) {id_min[id] = min_index[id];}
+    if (id_max.count(id) == 0) {id_max[id] = max_index[id];}
+    for (char i = 0; i < 3; i++){
+      if (id_min[id][i] > min_index[id][i]) {id_min[id][i] = min_index[id][i];}
+      if (id_max[id][i] < max_index[id][i]) {id_max[id][i] = max_index[id][i];}
+    }
+  }
 }
 
 void Space::setUnitCellIndexes(){
@@ -326,163 +598,147 @@ void Space::setUnitCellIndexes(){
 // SURFACE AREA //
 //////////////////
 
-// overloaded for full molecule surfaces
-// sets the appropriate start and end indices
-double Space::calcSurfArea(const std::vector<char>& types){
-  std::array<unsigned,3> start_index = _unit_cell? _unit_cell_start_index : std::array<unsigned,3>({0,0,0});
-  std::array<unsigned,3> end_index   = _unit_cell? _unit_cell_end_index   : getGrid(0).getNumElements<unsigned>();
-  double surface = tallySurface(types, start_index, end_index);
-  // scale the surface area in squared gridstep units
-  return (surface * (_grid_size*_grid_size));
+// solid state of the bottom level voxels inside of a box, one bit per voxel. every row along x
+// starts with a new word, so that rows can be combined word by word
+struct SolidBits{
+  std::array<unsigned long,3> n; // size of the box
+  unsigned long n_words; // words per row
+  std::vector<uint64_t> words;
+
+  const uint64_t* row(const unsigned long y, const unsigned long z) const {
+    return words.data() + (z*n[1] + y)*n_words;
+  }
+};
+
+// the surface sweeps split the grid along z into slabs of a fixed number of planes, which are counted
+// separately and then combined
+static constexpr unsigned long s_slab_planes = 4;
+
+size_t Space::numSlabs(const unsigned long n_planes){
+  return (n_planes + s_slab_planes - 1)/s_slab_planes;
 }
 
-// overload for cavity surfaces
-// solid types MUST also have appropriate ID!
-double Space::calcSurfArea(const std::vector<char>& types, const unsigned char id, std::array<unsigned int,3> start_index, std::array<unsigned int,3> end_index){
-  if(Ctrl::getInstance()->getAbortFlag()){return 0;}
-  // the surface area is counted between voxels, thus we need to check voxels around the limits of the cavity
-  if(!_unit_cell){
-    for(char i = 0; i < 3; i++){
-      std::array<unsigned long,3> n_elements = getGrid(0).getNumElements();
-      if(start_index[i] > 0){start_index[i]--;}
-      // increase end_index twice because it should be above the range of indexes checked like vector and array sizes in C++
-      if(end_index[i] < n_elements[i]){end_index[i]++;}
-      if(end_index[i] < n_elements[i]){end_index[i]++;}
-    }
+void Space::forEachSlab(const unsigned long n_planes, const std::function<void(const size_t, const unsigned long, const unsigned long)>& func){
+  const size_t n_slabs = numSlabs(n_planes);
+  auto runSlab = [&](const size_t slab){
+    func(slab, slab*s_slab_planes, std::min(n_planes, (slab+1)*s_slab_planes));
+  };
+  if (n_slabs > 1 && TileScheduler::resolveNumThreads(_n_threads) > 1){
+    TileScheduler scheduler({1, 1, unsigned(n_slabs)}, {1, 1, 1}, _n_threads);
+    runTilesInParallel(scheduler, [&](const TileScheduler::Tile& tile){runSlab(tile.start[2]);});
+    return;
   }
-  // for unit cell analysis, surfaces outside the unit cell should not be included
-  else{
-    for(char i = 0; i < 3; i++){
-      if(start_index[i] > _unit_cell_start_index[i]){start_index[i]--;}
-      // increase end_index twice because it should be above the range of indexes checked like vector and array sizes in C++
-      if(end_index[i] < _unit_cell_end_index[i]){end_index[i]++;}
-      if(end_index[i] < _unit_cell_end_index[i]){end_index[i]++;}
-    }
+  _progress->addWork(n_slabs);
+  for (size_t slab = 0; slab < n_slabs; ++slab){
+    if(_progress->isAborted()){return;}
+    runSlab(slab);
+    _progress->addProgress();
+    _reporter->updateProgressBar(int(100*double(slab+1)/double(n_slabs)));
   }
-  double surface = tallySurface(types, start_index, end_index, id, true);
-  // scale the surface area in squared gridstep units
-  return (surface * (_grid_size*_grid_size));
 }
 
-double Space::tallySurface(const std::vector<char>& types, std::array<unsigned int,3>& start_index, std::array<unsigned int,3>& end_index, const unsigned char id, const bool cavity){
-  double surface = 0;
-
-  // loop over all voxels within range minus one in each direction because the +1 neighbors will be checked at the same time
+// calls func(index, weight) for every marching cube at the border of the unit cell. the weight is the
+// fraction of the cube's surface area that belongs to the unit cell
+template <typename CubeFunc>
+void Space::forEachUnitCellBorderCube(const CubeFunc& func){
   std::array<unsigned int,3> index;
-  Ctrl::getInstance()->updateCalculationStatus();
-  for(index[2] = start_index[2]; index[2] < end_index[2]-1; index[2]++){
-    for(index[1] = start_index[1]; index[1] < end_index[1]-1; index[1]++){
-      if(Ctrl::getInstance()->getAbortFlag()){return 0;}
-      for(index[0] = start_index[0]; index[0] < end_index[0]-1; index[0]++){
-        surface += SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity));
-      }
-    }
+  /* the surface area is counted between voxels, thus the borders of the unit cell should include partial surface area by configuration
+  since the surface area is not homogeneous over the voxel, the surface area from the borders will be an approximation
+  -1,-1,-1 *1/8 on 1 vertex
+  -1,-1,i  *1/4 on 3 edges
+  -1,i,i   *1/2 on 3 faces
+  -1,n,i   *((1/4)+(mod/2)) on 6 edges
+  -1,-1,n  *((1/8)+(mod/4)) on 3 vertices
+  -1,n,n   *((1/8)+(modA/4)+(modB/4)+(modA*modB/2)) on 3 vertices
+  n,i,i    *((1/2)+mod) on 3 faces
+  n,n,i    *((1/4)+(modA/2)+(modB/2)+(modA*modB)) on 3 edges
+  n,n,n    *((1/8)+(modA/4)+(modB/4)+(modC/4)+(modA*modB/2)+(modA*modC/2)+(modB*modC/2)+(modA*modB*modC)) on 1 vertex
+  */
+
+  // add first -1,-1,-1 vertex
+  for(int i = 0; i < 3; i++){
+    index[i] = _unit_cell_start_index[i]-1;
   }
-  if(_unit_cell){
-    /* the surface area is counted between voxels, thus the borders of the unit cell should include partial surface area by configuration
-    since the surface area is not homogeneous over the voxel, the surface area from the borders will be an approximation
-    -1,-1,-1 *1/8 on 1 vertex
-    -1,-1,i  *1/4 on 3 edges
-    -1,i,i   *1/2 on 3 faces
-    -1,n,i   *((1/4)+(mod/2)) on 6 edges
-    -1,-1,n  *((1/8)+(mod/4)) on 3 vertices
-    -1,n,n   *((1/8)+(modA/4)+(modB/4)+(modA*modB/2)) on 3 vertices
-    n,i,i    *((1/2)+mod) on 3 faces
-    n,n,i    *((1/4)+(modA/2)+(modB/2)+(modA*modB)) on 3 edges
-    n,n,n    *((1/8)+(modA/4)+(modB/4)+(modC/4)+(modA*modB/2)+(modA*modC/2)+(modB*modC/2)+(modA*modB*modC)) on 1 vertex
-    */
-
-    // add first -1,-1,-1 vertex
-    for(int i = 0; i < 3; i++){
-      index[i] = _unit_cell_start_index[i]-1;
-    }
-    surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * 0.125);
+  func(index, 0.125);
 
-    // add last n,n,n vertex
-    for(int i = 0; i < 3; i++){
-      index[i] = _unit_cell_end_index[i]-1;
+  // add last n,n,n vertex
+  for(int i = 0; i < 3; i++){
+    index[i] = _unit_cell_end_index[i]-1;
+  }
+  func(index, (0.125 +
+               ((_unit_cell_mod_index[0] + _unit_cell_mod_index[1] + _unit_cell_mod_index[2])/4) +
+               (_unit_cell_mod_index[0] * _unit_cell_mod_index[1]/2) +
+               (_unit_cell_mod_index[0] * _unit_cell_mod_index[2]/2) +
+               (_unit_cell_mod_index[1] * _unit_cell_mod_index[2]/2) +
+               (_unit_cell_mod_index[0] * _unit_cell_mod_index[1] * _unit_cell_mod_index[2])));
+
+  // swap x,y,z
+  for(int n = 0; n < 3; n++){
+    int i = n;
+    int j = (n+1)%3;
+    int k = (n+2)%3;
+
+    // add the first three intermediate vertices -1,-1,n
+    index[i] = _unit_cell_start_index[i]-1;
+    index[j] = _unit_cell_start_index[j]-1;
+    index[k] = _unit_cell_end_index[k]-1;
+    func(index, (0.125 + (_unit_cell_mod_index[k]/4)));
+
+    // add the last three intermediate vertices -1,n,n
+    index[i] = _unit_cell_start_index[i]-1;
+    index[j] = _unit_cell_end_index[j]-1;
+    index[k] = _unit_cell_end_index[k]-1;
+    func(index, (0.125 +
+                 ((_unit_cell_mod_index[j] + _unit_cell_mod_index[k])/4) +
+                 (_unit_cell_mod_index[j] * _unit_cell_mod_index[k]/2)));
+
+    // add the three start edges -1,-1,k
+    index[i] = _unit_cell_start_index[i]-1;
+    index[j] = _unit_cell_start_index[j]-1;
+    for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
+      func(index, 0.25);
     }
-    surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) *
-                (0.125 +
-                 ((_unit_cell_mod_index[0] + _unit_cell_mod_index[1] + _unit_cell_mod_index[2])/4) +
-                 (_unit_cell_mod_index[0] * _unit_cell_mod_index[1]/2) +
-                 (_unit_cell_mod_index[0] * _unit_cell_mod_index[2]/2) +
-                 (_unit_cell_mod_index[1] * _unit_cell_mod_index[2]/2) +
-                 (_unit_cell_mod_index[0] * _unit_cell_mod_index[1] * _unit_cell_mod_index[2])));
 
-    // swap x,y,z
-    for(int n = 0; n < 3; n++){
-      int i = n;
-      int j = (n+1)%3;
-      int k = (n+2)%3;
+    // add the three end edges n,n,k
+    index[i] = _unit_cell_end_index[i]-1;
+    index[j] = _unit_cell_end_index[j]-1;
+    for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
+      func(index, (0.25 +
+                   ((_unit_cell_mod_index[j] + _unit_cell_mod_index[k])/2) +
+                   (_unit_cell_mod_index[j] * _unit_cell_mod_index[k])));
+    }
 
-      // add the first three intermediate vertices -1,-1,n
-      index[i] = _unit_cell_start_index[i]-1;
-      index[j] = _unit_cell_start_index[j]-1;
-      index[k] = _unit_cell_end_index[k]-1;
-      surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * (0.125 + (_unit_cell_mod_index[k]/4)));
-
-      // add the last three intermediate vertices -1,n,n
-      index[i] = _unit_cell_start_index[i]-1;
-      index[j] = _unit_cell_end_index[j]-1;
-      index[k] = _unit_cell_end_index[k]-1;
-      surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) *
-                  (0.125 +
-                   ((_unit_cell_mod_index[j] + _unit_cell_mod_index[k])/4) +
-                   (_unit_cell_mod_index[j] * _unit_cell_mod_index[k]/2)));
-
-      // add the three start edges -1,-1,k
-      index[i] = _unit_cell_start_index[i]-1;
-      index[j] = _unit_cell_start_index[j]-1;
+    // add the three start faces -1,j,k
+    index[i] = _unit_cell_start_index[i]-1;
+    for (index[j] = _unit_cell_start_index[j]; index[j] < _unit_cell_end_index[j]-1; index[j]++){
       for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-        surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * 0.25);
+        func(index, 0.5);
       }
+    }
 
-      // add the three end edges n,n,k
-      index[i] = _unit_cell_end_index[i]-1;
-      index[j] = _unit_cell_end_index[j]-1;
+    // add the three end faces n,j,k
+    index[i] = _unit_cell_end_index[i]-1;
+    for (index[j] = _unit_cell_start_index[j]; index[j] < _unit_cell_end_index[j]-1; index[j]++){
       for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-        surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) *
-                    (0.25 +
-                     ((_unit_cell_mod_index[j] + _unit_cell_mod_index[k])/2) +
-                     (_unit_cell_mod_index[j] * _unit_cell_mod_index[k])));
-      }
-
-      // add the three start faces -1,j,k
-      index[i] = _unit_cell_start_index[i]-1;
-      for (index[j] = _unit_cell_start_index[j]; index[j] < _unit_cell_end_index[j]-1; index[j]++){
-        for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-          surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * 0.5);
-        }
-      }
-
-      // add the three end faces n,j,k
-      index[i] = _unit_cell_end_index[i]-1;
-      for (index[j] = _unit_cell_start_index[j]; index[j] < _unit_cell_end_index[j]-1; index[j]++){
-        for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-          surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * (0.5 + _unit_cell_mod_index[i]));
-        }
+        func(index, (0.5 + _unit_cell_mod_index[i]));
       }
+    }
 
-      // add the six intermediate edges -1,n,k and n,-1,k
-      index[i] = _unit_cell_start_index[i]-1;
-      index[j] = _unit_cell_end_index[j]-1;
-      for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-        surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * (0.25 + (_unit_cell_mod_index[j]/2)));
-      }
-      index[i] = _unit_cell_end_index[i]-1;
-      index[j] = _unit_cell_start_index[j]-1;
-      for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
-        surface += (SurfaceLUT::configToArea(evalMarchingCubeConfig(index, types, id, cavity)) * (0.25 + (_unit_cell_mod_index[i]/2)));
-      }
+    // add the six intermediate edges -1,n,k and n,-1,k
+    index[i] = _unit_cell_start_index[i]-1;
+    index[j] = _unit_cell_end_index[j]-1;
+    for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
+      func(index, (0.25 + (_unit_cell_mod_index[j]/2)));
+    }
+    index[i] = _unit_cell_end_index[i]-1;
+    index[j] = _unit_cell_start_index[j]-1;
+    for (index[k] = _unit_cell_start_index[k]; index[k] < _unit_cell_end_index[k]-1; index[k]++){
+      func(index, (0.25 + (_unit_cell_mod_index[i]/2)));
     }
   }
-  return surface;
 }
 
-bool isSolid(const Voxel&, const std::vector<char>&);
-
-unsigned char Space::evalMarchingCubeConfig(const std::array<unsigned int,3>& index, const std::vector<char>& types, const unsigned char id, const bool cavity){
+unsigned char Space::evalMarchingCubeConfig(const std::array<unsigned int,3>& index, const std::array<bool,256>& solid, const Cavity::id_type id, const bool cavity){
   unsigned char config = 0; // configuration of the marching cube stored as a byte
   // check the starting voxel and its 7 neighbors to define a marching cube configuration
   std::array<unsigned,3> subindex;
@@ -493,8 +749,8 @@ unsigned char Space::evalMarchingCubeConfig(const std::array<unsigned int,3>& in
       for(unsigned int z = 0; z < 2; z++){
         subindex[2] = index[2] + z;
         // condition for a bit to be true in the byte
-        bool bit_state = isSolid(getVxlFromGrid(subindex, 0), types);
-        if (cavity) {bit_state &= getVxlFromGrid(subindex, 0).getID() == id;}
+        bool bit_state = solid[(unsigned char)getType(subindex, 0)];
+        if (cavity) {bit_state &= getID(subindex, 0) == id;}
         setBit(config, z + 2*y + 4*x, bit_state);
       }
     }
@@ -502,8 +758,302 @@ unsigned char Space::evalMarchingCubeConfig(const std::array<unsigned int,3>& in
   return config;
 }
 
-inline bool isSolid(const Voxel& vxl, const std::vector<char>& solid_types){
-  return std::find(solid_types.begin(), solid_types.end(), vxl.getType()) != solid_types.end();
+// lookup table that tells for each of the 256 possible type bytes whether it is solid
+std::array<bool,256> solidTypeLUT(const std::vector<char>& solid_types){
+  std::array<bool,256> solid;
+  solid.fill(false);
+  for (const char type : solid_types){
+    solid[(unsigned char)type] = true;
+  }
+  return solid;
+}
+
+// calls func(x, config) for the marching cubes along one row in ascending order of x, which keeps
+// the order of the summation. rows are the four rows of bits that hold the corners of the cubes,
+// ordered like the bits of the configuration (dz + 2*dy). they give the first four bits of the
+// configurations, the same rows shifted by one voxel give the other four bits, so that the corners
+// of 64 cubes are combined at once. cubes without any set corner are skipped. if SKIP_FULL is true,
+// cubes whose corners are all set are skipped as well, since they have no surface either
+template <bool SKIP_FULL, typename CubeFunc>
+inline void forEachCubeOfRow(const std::array<const uint64_t*,4>& rows, const unsigned long n_words,
+    const unsigned long n_cubes, const CubeFunc& func){
+  std::array<uint64_t,8> corners;
+  for (unsigned long w = 0; 64*w < n_cubes; ++w){
+    for (char i = 0; i < 4; ++i){
+      corners[i] = rows[i][w];
+      corners[i+4] = (rows[i][w] >> 1) | ((w+1 < n_words)? rows[i][w+1] << 63 : 0);
+    }
+    uint64_t selected = 0;
+    for (char i = 0; i < 8; ++i){
+      selected |= SKIP_FULL? corners[i] ^ corners[0] : corners[i];
+    }
+    if (n_cubes - 64*w < 64){selected &= (uint64_t(1) << (n_cubes - 64*w)) - 1;}
+    while (selected){
+      const int b = std::countr_zero(selected);
+      unsigned char config = 0;
+      for (char i = 0; i < 8; ++i){
+        config |= ((corners[i] >> b) & 1) << i;
+      }
+      func(64*w + b, config);
+      selected &= selected - 1;
+    }
+  }
+}
+
+/////////////////////////
+// FUSED SURFACE AREAS //
+/////////////////////////
+
+// one plane of bottom level voxels of the fused surface sweep. for every set of solid types and for the
+// voxels that belong to a cavity, the plane holds one bit per voxel. in addition, it keeps the sets of
+// every voxel as a mask and its cavity id, both indexed by y*n[0] + x
+struct SolidPlane{
+  std::vector<SolidBits> sets;
+  std::vector<unsigned char> masks;
+  std::vector<Cavity::id_type> ids;
+};
+
+// bits of the cavity sets in the masks of SolidPlane. the other bits belong to the sets of solid types
+constexpr unsigned char s_cav_shell_bit = 1 << 6;
+constexpr unsigned char s_cav_core_bit = 1 << 7;
+
+// passes the configurations of the marching cube to each cavity that one of its corners belongs to. the
+// corners are ordered like the bits of the configuration (z + 2*y + 4*x). add is called with the id
+// of the cavity and the configurations of its shell and its core
+template <typename AddFunc>
+void addCavityCube(const std::array<Cavity::id_type,8>& ids, const std::array<unsigned char,8>& masks, const AddFunc& add){
+  const unsigned char cav_bits = s_cav_shell_bit | s_cav_core_bit;
+  for (char i = 0; i < 8; ++i){
+    if (!ids[i] || !(masks[i] & cav_bits)){continue;}
+    bool counted = false; // every cavity only once per cube
+    for (char j = 0; j < i; ++j){
+      counted |= ids[j] == ids[i] && (masks[j] & cav_bits);
+    }
+    if (counted){continue;}
+    unsigned char shell_config = 0;
+    unsigned char core_config = 0;
+    for (char j = 0; j < 8; ++j){
+      if (ids[j] != ids[i]){continue;}
+      shell_config |= bool(masks[j] & s_cav_shell_bit) << j;
+      core_config |= bool(masks[j] & s_cav_core_bit) << j;
+    }
+    add(ids[i], shell_config, core_config);
+  }
+}
+
+// counts of one slab of the fused surface sweep. the cavities are listed in ascending order of their
+// ids with the counts of their shell and core
+struct SlabSums{
+  std::vector<SurfaceHistogram> total;
+  std::vector<std::pair<Cavity::id_type, std::array<SurfaceHistogram,2>>> cavities;
+};
+
+// the surface of a cavity is counted over all cubes that have a corner in the cavity, so that cubes
+// outside of the cavity's bounding box are not needed
+Space::SurfaceSums Space::calcSurfAreas(const std::vector<std::vector<char>>& types,
+    const std::vector<char>& shell_types, const std::vector<char>& core_types){
+  const unsigned n_sets = types.size();
+  assert(n_sets <= 6);
+  std::vector<std::array<bool,256>> solid;
+  std::array<unsigned char,256> set_masks;
+  set_masks.fill(0);
+  for (unsigned s = 0; s < n_sets; ++s){
+    solid.push_back(solidTypeLUT(types[s]));
+    for (const char type : types[s]){set_masks[(unsigned char)type] |= 1 << s;}
+  }
+  for (const char type : shell_types){set_masks[(unsigned char)type] |= s_cav_shell_bit;}
+  for (const char type : core_types){set_masks[(unsigned char)type] |= s_cav_core_bit;}
+
+  SurfaceSums sums;
+  sums.total.resize(n_sets);
+  sums.face_area = _grid_size*_grid_size;
+
+  const std::array<unsigned,3> start_index = _unit_cell? _unit_cell_start_index : std::array<unsigned,3>({0,0,0});
+  const std::array<unsigned,3> end_index = _unit_cell? _unit_cell_end_index : getGridstepsOnLvl<unsigned>(0);
+  std::array<unsigned long,3> n;
+  for (char i = 0; i < 3; ++i){
+    n[i] = end_index[i] > start_index[i]? end_index[i] - start_index[i] : 0;
+  }
+  const unsigned long n_words = (n[0] + 63)/64;
+
+  auto readPlane = [&](SolidPlane& plane, const unsigned long z){
+    // readRow indexes the buffers by x
+    std::vector<Voxel> type_row(end_index[0]);
+    std::vector<Cavity::id_type> id_row(end_index[0]);
+    plane.sets.resize(n_sets+1); // the last set holds the voxels that belong to a cavity
+    for (SolidBits& bits : plane.sets){
+      bits.n = {n[0], n[1], 1};
+      bits.n_words = n_words;
+      bits.words.assign(n_words * n[1], 0);
+    }
+    plane.masks.resize(n[0]*n[1]);
+    plane.ids.resize(n[0]*n[1]);
+    for (unsigned long y = 0; y < n[1]; ++y){
+      readRow(0, start_index[1]+y, start_index[2]+z, start_index[0], end_index[0], type_row.data(), id_row.data());
+      for (unsigned long x = 0; x < n[0]; ++x){
+        const Cavity::id_type id = id_row[start_index[0]+x];
+        unsigned char mask = set_masks[(unsigned char)type_row[start_index[0]+x].getType()];
+        plane.masks[y*n[0] + x] = mask;
+        plane.ids[y*n[0] + x] = id;
+        if (!id){mask &= ~(s_cav_shell_bit | s_cav_core_bit);}
+        for (unsigned s = 0; s <= n_sets; ++s){
+          const bool bit_state = (s == n_sets)? mask & (s_cav_shell_bit | s_cav_core_bit) : (mask >> s) & 1;
+          plane.sets[s].words[y*n_words + (x >> 6)] |= uint64_t(bit_state) << (x & 63);
+        }
+      }
+    }
+  };
+
+  _progress->beginStage(CalcStage::surface);
+  _reporter->updateCalculationStatus();
+  const unsigned long n_cube_planes = (n[0] >= 2 && n[1] >= 2 && n[2] >= 2)? n[2]-1 : 0;
+  std::vector<SlabSums> slab_sums(numSlabs(n_cube_planes));
+  forEachSlab(n_cube_planes, [&](const size_t slab, const unsigned long z_begin, const unsigned long z_end){
+    SlabSums& partial = slab_sums[slab];
+    partial.total.assign(n_sets, SurfaceHistogram());
+    partial.cavities.clear();
+    // position of every cavity id in the list of the slab plus one, zero for ids that were not touched yet
+    thread_local std::vector<size_t> cavity_pos;
+    cavity_pos.resize(size_t(std::numeric_limits<Cavity::id_type>::max()) + 1, 0);
+    auto addCavity = [&partial](const Cavity::id_type id, const unsigned char shell_config, const unsigned char core_config){
+      if (!cavity_pos[id]){
+        partial.cavities.emplace_back(id, std::array<SurfaceHistogram,2>());
+        cavity_pos[id] = partial.cavities.size();
+      }
+      std::array<SurfaceHistogram,2>& cavity = partial.cavities[cavity_pos[id]-1].second;
+      cavity[0].add(shell_config);
+      cavity[1].add(core_config);
+    };
+
+    const unsigned long n_cubes = n[0]-1; // cubes along x
+    // the sweep holds two planes at a time. every plane of the slab is read once
+    std::array<SolidPlane,2> planes;
+    std::array<const uint64_t*,4> rows;
+    readPlane(planes[1], z_begin);
+    for (unsigned long z = z_begin; z < z_end; ++z){
+      std::swap(planes[0], planes[1]);
+      readPlane(planes[1], z+1);
+      for (unsigned long y = 0; y+1 < n[1]; ++y){
+        if(_progress->isAborted()){break;}
+        for (unsigned s = 0; s <= n_sets; ++s){
+          for (char i = 0; i < 4; ++i){
+            rows[i] = planes[i%2].sets[s].row(y + i/2, 0);
+          }
+          if (s < n_sets){
+            SurfaceHistogram& surface = partial.total[s];
+            forEachCubeOfRow<true>(rows, n_words, n_cubes, [&surface](const unsigned long, const unsigned char config){
+              surface.add(config);
+            });
+            continue;
+          }
+          // every cube that touches a cavity
+          forEachCubeOfRow<false>(rows, n_words, n_cubes, [&](const unsigned long x, const unsigned char){
+            std::array<Cavity::id_type,8> corner_ids;
+            std::array<unsigned char,8> corner_masks;
+            for (char i = 0; i < 8; ++i){
+              const unsigned long pos = (y + (i/2)%2)*n[0] + x + i/4;
+              corner_ids[i] = planes[i%2].ids[pos];
+              corner_masks[i] = planes[i%2].masks[pos];
+            }
+            addCavityCube(corner_ids, corner_masks, addCavity);
+          });
+        }
+      }
+    }
+    for (const auto& cavity : partial.cavities){
+      cavity_pos[cavity.first] = 0;
+    }
+  });
+  if(_progress->isAborted()){return sums;}
+
+  for (const SlabSums& partial : slab_sums){
+    for (unsigned s = 0; s < n_sets; ++s){
+      sums.total[s] += partial.total[s];
+    }
+    for (const auto& [id, counts] : partial.cavities){
+      sums.cavities[id][0] += counts[0];
+      sums.cavities[id][1] += counts[1];
+    }
+  }
+  if(_unit_cell){
+    forEachUnitCellBorderCube([&](const std::array<unsigned int,3>& index, const double weight){
+      for (unsigned s = 0; s < n_sets; ++s){
+        sums.total[s].add(evalMarchingCubeConfig(index, solid[s], 0, false), weight);
+      }
+      std::array<Cavity::id_type,8> corner_ids;
+      std::array<unsigned char,8> corner_masks;
+      for (char i = 0; i < 8; ++i){
+        const std::array<unsigned,3> corner = {index[0] + i/4, index[1] + (i/2)%2, index[2] + i%2};
+        corner_ids[i] = getID(corner, 0);
+        corner_masks[i] = set_masks[(unsigned char)getType(corner, 0)];
+      }
+      addCavityCube(corner_ids, corner_masks, [&](const Cavity::id_type id, const unsigned char shell_config, const unsigned char core_config){
+        sums.cavities[id][0].add(shell_config, weight);
+        sums.cavities[id][1].add(core_config, weight);
+      });
+    });
+  }
+  return sums;
+}
+
+double Space::SurfaceSums::totalArea(const unsigned set, const AreaTable table) const {
+  return total[set].area(table) * face_area;
+}
+
+double Space::SurfaceSums::cavityShellArea(const Cavity::id_type id, const AreaTable table) const {
+  const auto it = cavities.find(id);
+  return (it == cavities.end())? 0 : it->second[0].area(table) * face_area;
+}
+
+double Space::SurfaceSums::cavityCoreArea(const Cavity::id_type id, const AreaTable table) const {
+  const auto it = cavities.find(id);
+  return (it == cavities.end())? 0 : it->second[1].area(table) * face_area;
+}
+
+///////////////////////
+// SURFACE HISTOGRAM //
+///////////////////////
+
+// there are only a few different weights at the border of the unit cell
+std::array<uint64_t,256>& SurfaceHistogram::getCounts(const double weight){
+  if (weight == 1){return _interior;}
+  for (auto& [border_weight, counts] : _border){
+    if (border_weight == weight){return counts;}
+  }
+  _border.emplace_back(weight, std::array<uint64_t,256>());
+  return _border.back().second;
+}
+
+void SurfaceHistogram::add(const unsigned char config, const double weight){
+  getCounts(weight)[config]++;
+}
+
+SurfaceHistogram& SurfaceHistogram::operator+=(const SurfaceHistogram& other){
+  for (unsigned config = 0; config < 256; ++config){
+    _interior[config] += other._interior[config];
+  }
+  for (const auto& [weight, other_counts] : other._border){
+    std::array<uint64_t,256>& counts = getCounts(weight);
+    for (unsigned config = 0; config < 256; ++config){
+      counts[config] += other_counts[config];
+    }
+  }
+  return *this;
+}
+
+double SurfaceHistogram::area(const AreaTable table) const {
+  auto dot = [table](const std::array<uint64_t,256>& counts){
+    double sum = 0;
+    for (unsigned config = 0; config < 256; ++config){
+      sum += counts[config] * SurfaceLUT::configToArea(config, table);
+    }
+    return sum;
+  };
+  double surface = dot(_interior);
+  for (const auto& [weight, counts] : _border){
+    surface += dot(counts) * weight;
+  }
+  return surface;
 }
 
 //////////////////////
@@ -534,32 +1084,79 @@ double Space::getVxlSize() const {
   return _grid_size;
 }
 
-const Container3D<Voxel>& Space::getGrid(const unsigned lvl) const{
-  return _grid[lvl];
+void Space::setReporter(Reporter& reporter){
+  _reporter = &reporter;
+  _progress = &reporter.getProgressToken();
 }
 
 /////////////////
 // GET ELEMENT //
 /////////////////
 
-Voxel& Space::getVxlFromGrid(const unsigned int i, unsigned lvl){
-  return _grid[lvl].getElement(i);
-}
-
 Voxel& Space::getVxlFromGrid(const unsigned int x, const unsigned int y, const unsigned int z, unsigned lvl){
+  if (_sparse){return _sparse_grid.getVoxel(std::array<unsigned,3>({x,y,z}), lvl);}
   return _grid[lvl].getElement(x,y,z);
 }
 
 Voxel& Space::getVxlFromGrid(const std::array<unsigned int,3> arr, unsigned lvl){
+  if (_sparse){return _sparse_grid.getVoxel(arr, lvl);}
   return _grid[lvl].getElement(arr);
 }
 
 Voxel& Space::getVxlFromGrid(const std::array<int,3> arr, unsigned lvl){
+  if (_sparse){return _sparse_grid.getVoxel(arr, lvl);}
   return _grid[lvl].getElement(arr);
 }
 
-Voxel& Space::getTopVxl(const unsigned int i){
-  return getVxlFromGrid(i, _max_depth);
+void Space::readRow(const int lvl, const unsigned y, const unsigned z, const unsigned x_begin, const unsigned x_end,
+    Voxel* types, Cavity::id_type* ids) const {
+  if (_sparse){
+    _sparse_grid.readRow(lvl, y, z, x_begin, x_end, types, ids);
+    return;
+  }
+  for (unsigned x = x_begin; x < x_end; ++x){
+    types[x] = _grid[lvl].getElement(x, y, z);
+  }
+  if (!ids){return;}
+  for (unsigned x = x_begin; x < x_end; ++x){
+    ids[x] = getID(std::array<unsigned,3>({x, y, z}), lvl);
+  }
+}
+
+// in dense mode, the descendants of a voxel occupy one contiguous range on every lower level (see
+// MortonLayout). the range of the next lower level starts and ends at eight times the current range.
+// in sparse mode, a pure voxel has no descendants, they are resolved to the voxel on access instead
+template <typename T>
+void fillSubtree(std::vector<Container3D<T,MortonLayout>>& planes, const std::array<unsigned,3>& index, const int lvl, const T value){
+  unsigned long begin = planes[lvl].getPos(index);
+  unsigned long end = begin + 1;
+  for (int sublvl = lvl-1; sublvl >= 0; --sublvl){
+    begin *= 8;
+    end *= 8;
+    std::fill(planes[sublvl].data() + begin, planes[sublvl].data() + end, value);
+  }
+}
+
+void Space::fillSubtreeType(const std::array<unsigned,3>& index, const int lvl, const char type){
+  if (_sparse){return;}
+  Voxel vxl;
+  vxl.setType(type);
+  fillSubtree(_grid, index, lvl, vxl);
+}
+
+void Space::fillSubtreeID(const std::array<unsigned,3>& index, const int lvl, const Cavity::id_type id){
+  if (_sparse){return;}
+  if (_wide_ids.empty()){fillSubtree(_ids, index, lvl, (unsigned char)id);}
+  else {fillSubtree(_wide_ids, index, lvl, id);}
+}
+
+// in sparse mode, a voxel that is split needs memory for its subvoxels. in dense mode all voxels exist anyway.
+// called for every voxel that is split, so it also counts the splits
+void Space::allocateSubvoxels(const std::array<unsigned,3>& index, const int lvl, const char type){
+  if (ProfileCounts* counts = Profiler::counts()){
+    counts->split_vxls[std::min<size_t>(lvl, ProfileCounts::s_n_lvls-1)]++;
+  }
+  if (_sparse){_sparse_grid.allocateSubvoxels(index, lvl, type);}
 }
 
 Voxel& Space::getTopVxl(const unsigned int x, const unsigned int y, const unsigned int z){
@@ -578,14 +1175,16 @@ Voxel& Space::getTopVxl(const std::array<int,3> arr){
 
 // check whether coord is inside grid bounds
 bool Space::isInBounds(const std::array<int,3>& coord, const unsigned lvl){
+  const std::array<unsigned long,3>& n_vxl = getLevelConstants(lvl).n_vxl;
   for (char i = 0; i < 3; i++){
-    if(coord[i] < 0 || coord[i] >= getGridsteps()[i] * std::pow(2,_max_depth-lvl)){return false;}
+    if(coord[i] < 0 || (unsigned long)coord[i] >= n_vxl[i]){return false;}
   }
   return true;
 }
 bool Space::isInBounds(const std::array<unsigned,3>& coord, const unsigned lvl){
+  const std::array<unsigned long,3>& n_vxl = getLevelConstants(lvl).n_vxl;
   for (char i = 0; i < 3; i++){
-    if(coord[i] < 0 || coord[i] >= getGridsteps()[i] * std::pow(2,_max_depth-lvl)){return false;}
+    if(coord[i] >= n_vxl[i]){return false;}
   }
   return true;
 }
@@ -684,7 +1283,7 @@ void Space::printGrid(){
       for(unsigned int x = x_min; x < x_max; x++){
         char to_print;
         if (disp_id){
-          to_print = ('0' + getVxlFromGrid(x,y,z, _max_depth-depth).getID());
+          to_print = ('0' + getID(std::array<unsigned,3>({x,y,z}), _max_depth-depth));
         }
         else{
           to_print = (getVxlFromGrid(x,y,z,_max_depth-depth).getType() == 0b00000011)? 'A' : 'O';
@@ -715,15 +1314,15 @@ void Space::printGrid(){
 
 const constexpr std::array<unsigned char,256> SurfaceLUT::types_by_config = {1,2,2,3,2,3,4,6,2,4,3,6,3,6,6,9,2,3,4,6,4,6,8,10,5,7,7,13,7,13,11,6,2,4,3,6,5,7,7,13,4,8,6,10,7,11,13,6,3,6,6,9,7,13,11,6,7,11,13,6,12,7,7,3,2,4,5,7,3,6,7,13,4,8,7,11,6,10,13,6,3,6,7,13,6,9,11,6,7,11,12,7,13,6,7,3,4,8,7,11,7,11,12,7,8,14,11,8,11,8,7,4,6,10,13,6,13,6,7,3,11,8,7,4,7,4,5,2,2,5,4,7,4,7,8,11,3,7,6,13,6,13,10,6,4,7,8,11,8,11,14,8,7,12,11,7,11,7,8,4,3,7,6,13,7,12,11,7,6,11,9,6,13,7,6,3,6,13,10,6,11,7,8,4,13,7,6,3,7,5,4,2,3,7,7,12,6,13,11,7,6,11,13,7,9,6,6,3,6,13,11,7,10,6,8,4,13,7,7,5,6,3,4,2,6,11,13,7,13,7,7,5,10,8,6,4,6,4,3,2,9,6,6,3,6,3,4,2,6,4,3,2,3,2,2,1};
 // Theoretical values from https://doi.org/10.1007/978-3-540-39966-7_33
-// const constexpr std::array<double, 15> SurfaceLUT::area_by_type = {0,0,0.2118,0.669,0.4236,0.4236,0.9779,0.8808,0.6354,0.927,1.2706,1.1897,1.338,1.5731,0.8472};
+const constexpr std::array<double, 15> SurfaceLUT::theoretical_area_by_type = {0,0,0.2118,0.669,0.4236,0.4236,0.9779,0.8808,0.6354,0.927,1.2706,1.1897,1.338,1.5731,0.8472};
 // Semi-empirical values from https://doi.org/10.1016/j.imavis.2004.06.012
 const constexpr std::array<double, 15> SurfaceLUT::area_by_type = {0,0,0.636,0.669,1.272,1.272,0.5537,1.305,1.908,0.927,0.4222,1.1897,1.338,1.5731,2.544};
 unsigned char SurfaceLUT::configToType(unsigned char config) {
   return types_by_config[config];
 }
-double SurfaceLUT::typeToArea(unsigned char type) {
-  return area_by_type[type];
+double SurfaceLUT::typeToArea(unsigned char type, const AreaTable table) {
+  return (table == AreaTable::theoretical)? theoretical_area_by_type[type] : area_by_type[type];
 }
-double SurfaceLUT::configToArea(unsigned char config) {
-  return area_by_type[types_by_config[config]];
+double SurfaceLUT::configToArea(unsigned char config, const AreaTable table) {
+  return typeToArea(types_by_config[config], table);
 }
@@ -0,0 +1,203 @@
+#include "space.h"
+#include "voxel.h"
+#include "tiling.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <limits>
+
+///////////////////////////////
+// PARALLEL CAVITY LABELLING //
+///////////////////////////////
+
+// the serial cavity identification visits all pure core voxels in a fixed order (see
+// Space::descendToCore) and starts a flood fill at each voxel that has not been assigned
+// an id yet. the cavity ids are therefore determined by the order in which the first voxel
+// of each cavity is visited. the parallel engine reproduces the same ids as follows:
+// 1) all pure core voxels are listed in visiting order, with one slab of top level voxels
+//    per task. the key of each voxel encodes its position in the visiting order
+// 2) neighbouring core voxels are joined with union-find. neighbours inside the same slab
+//    are joined by the worker threads, neighbours across slabs are joined afterwards
+// 3) each cavity is represented by its first voxel in visiting order, which gives its id
+// 4) ids are written into the grid. when entrances are counted, the flood fill starting at
+//    the first voxel is repeated for every cavity, with each cavity processed by one thread
+
+struct CoreVxl{
+  VoxelLoc loc;
+  uint64_t key;
+};
+
+uint64_t visitingOrderKey(Space&, const std::array<unsigned,3>&, const int);
+void listCoreVxls(Space&, std::vector<CoreVxl>&, const std::array<unsigned,3>&, const int);
+size_t findRoot(std::vector<size_t>&, size_t);
+void unite(std::vector<size_t>&, const size_t, const size_t);
+
+void Space::identifyCavitiesParallel(std::vector<Cavity>& cavities, const bool cavity_types){
+  const std::array<unsigned,3> n_top = getGridstepsOnLvl<unsigned>(_max_depth);
+  // one slab of top level voxels per tile, so that the tiles follow the visiting order
+  TileScheduler slabs(n_top, {1, n_top[1], n_top[2]}, _n_threads);
+
+  // list core voxels
+  std::vector<std::vector<CoreVxl>> slab_vxls(slabs.size());
+  runTilesInParallel(slabs, [&](const TileScheduler::Tile& tile){
+    std::array<unsigned,3> index;
+    for (index[0] = tile.start[0]; index[0] < tile.end[0]; index[0]++){
+      for (index[1] = tile.start[1]; index[1] < tile.end[1]; index[1]++){
+        for (index[2] = tile.start[2]; index[2] < tile.end[2]; index[2]++){
+          listCoreVxls(*this, slab_vxls[tile.start[0]], index, _max_depth);
+        }
+      }
+    }
+  });
+  if (_progress->isAborted()){return;}
+
+  std::vector<size_t> slab_begin(slab_vxls.size()+1, 0);
+  for (size_t i = 0; i < slab_vxls.size(); ++i){
+    slab_begin[i+1] = slab_begin[i] + slab_vxls[i].size();
+  }
+  std::vector<CoreVxl> core_vxls;
+  core_vxls.reserve(slab_begin.back());
+  for (std::vector<CoreVxl>& vxls : slab_vxls){
+    core_vxls.insert(core_vxls.end(), vxls.begin(), vxls.end());
+    std::vector<CoreVxl>().swap(vxls);
+  }
+  std::vector<uint64_t> keys(core_vxls.size());
+  for (size_t i = 0; i < core_vxls.size(); ++i){
+    keys[i] = core_vxls[i].key;
+  }
+
+  // join neighbours. the root of each set is always the voxel that comes first in visiting order
+  std::vector<size_t> parent(core_vxls.size());
+  for (size_t i = 0; i < parent.size(); ++i){parent[i] = i;}
+  std::vector<std::vector<std::pair<size_t,size_t>>> cross_slab_pairs(slabs.size());
+  runTilesInParallel(slabs, [&](const TileScheduler::Tile& tile){
+    const size_t begin = slab_begin[tile.start[0]];
+    const size_t end = slab_begin[tile.start[0]+1];
+    for (size_t i = begin; i < end; ++i){
+      if (_progress->isAborted()){return;}
+      const VoxelLoc& loc = core_vxls[i].loc;
+      for (const VoxelLoc& nb : getVxlFromGrid(loc.index, loc.lvl).findCoreNeighbours(loc)){
+        // a neighbour is either a listed voxel or lies inside of one. in both cases the listed
+        // voxel is the last voxel in visiting order whose key does not exceed the neighbour's key
+        const uint64_t nb_key = visitingOrderKey(*this, nb.index, nb.lvl);
+        const size_t j = std::upper_bound(keys.begin(), keys.end(), nb_key) - keys.begin() - 1;
+        if (j == i){continue;}
+        if (j >= begin && j < end){unite(parent, i, j);}
+        else {cross_slab_pairs[tile.start[0]].push_back(std::make_pair(i,j));}
+      }
+    }
+  });
+  if (_progress->isAborted()){return;}
+  for (const auto& pairs : cross_slab_pairs){
+    for (const auto& [i, j] : pairs){
+      unite(parent, i, j);
+    }
+  }
+
+  // assign ids in visiting order. like in the serial search, cavities beyond the largest id remain without id
+  const size_t max_id = std::numeric_limits<Cavity::id_type>::max();
+  std::vector<Cavity::id_type> vxl_ids(core_vxls.size(), 0);
+  std::vector<size_t> first_vxls;
+  bool cavities_exceeded = false;
+  for (size_t i = 0; i < core_vxls.size(); ++i){
+    const size_t root = findRoot(parent, i);
+    if (root == i){
+      if (first_vxls.size() == max_id){
+        cavities_exceeded = true;
+        continue;
+      }
+      first_vxls.push_back(i);
+      vxl_ids[i] = first_vxls.size();
+    }
+    else {
+      vxl_ids[i] = vxl_ids[root];
+    }
+  }
+  cavities_exceeded |= first_vxls.size() == max_id;
+  if (first_vxls.size() > std::numeric_limits<unsigned char>::max()){enableWideIDs();}
+
+  std::vector<Cavity> new_cavities(first_vxls.size());
+  if (cavity_types){
+    // the number of entrances depends on the path of the flood fill. each cavity is therefore
+    // flood filled exactly like in the serial search. cavities do not share any voxels, so
+    // they can be processed concurrently
+    TileScheduler fills({unsigned(first_vxls.size()), 1, 1}, 1, _n_threads);
+    runTilesInParallel(fills, [&](const TileScheduler::Tile& tile){
+      const size_t n = tile.start[0];
+      const VoxelLoc& loc = core_vxls[first_vxls[n]].loc;
+      std::vector<Cavity> filled;
+      if (getVxlFromGrid(loc.index, loc.lvl).floodFill(filled, n+1, loc.index, loc.lvl, true)){
+        new_cavities[n] = filled.front();
+      }
+    });
+  }
+  else {
+    // without cavity types the flood fill does not count entrances, so the ids can be written directly
+    runTilesInParallel(slabs, [&](const TileScheduler::Tile& tile){
+      for (size_t i = slab_begin[tile.start[0]]; i < slab_begin[tile.start[0]+1]; ++i){
+        if (!vxl_ids[i]){continue;}
+        const VoxelLoc& loc = core_vxls[i].loc;
+        setID(loc.index, loc.lvl, vxl_ids[i]);
+        getVxlFromGrid(loc.index, loc.lvl).passIDtoChildren(loc.index, loc.lvl);
+      }
+    });
+    for (size_t n = 0; n < first_vxls.size(); ++n){
+      new_cavities[n] = Cavity(n+1, 0);
+    }
+  }
+  if (_progress->isAborted()){return;}
+  cavities.insert(cavities.end(), new_cavities.begin(), new_cavities.end());
+
+  if (cavities_exceeded){
+    throw std::overflow_error("Too many isolated cavities detected!");
+  }
+}
+
+// the key consists of the index of the top level voxel, followed by one octal digit per
+// level that describes which subvoxel is chosen. missing digits below the voxel's level are
+// zero. because core voxels never contain each other, sorting by key yields the visiting order
+uint64_t visitingOrderKey(Space& cell, const std::array<unsigned,3>& index, const int lvl){
+  const int n_sublvl = cell.getMaxDepth() - lvl;
+  const std::array<unsigned long,3> n_top = cell.getGridsteps();
+  uint64_t key = ((uint64_t)(index[0] >> n_sublvl) * n_top[1] + (index[1] >> n_sublvl)) * n_top[2] + (index[2] >> n_sublvl);
+  for (int bit = n_sublvl-1; bit >= 0; --bit){
+    key = (key << 3) | (((index[0] >> bit) & 1) << 2) | (((index[1] >> bit) & 1) << 1) | ((index[2] >> bit) & 1);
+  }
+  return key << (3*lvl);
+}
+
+// same traversal as Space::descendToCore, but the pure core voxels are only listed
+void listCoreVxls(Space& cell, std::vector<CoreVxl>& list, const std::array<unsigned,3>& index, const int lvl){
+  Voxel& vxl = cell.getVxlFromGrid(index,lvl);
+  if (!vxl.isCore()){return;}
+  if (!vxl.hasSubvoxel()){
+    list.push_back({VoxelLoc(index, lvl), visitingOrderKey(cell, index, lvl)});
+    return;
+  }
+  std::array<unsigned,3> subindex;
+  for (char i = 0; i < 2; ++i){
+    subindex[0] = index[0]*2 + i;
+    for (char j = 0; j < 2; ++j){
+      subindex[1] = index[1]*2 + j;
+      for (char k = 0; k < 2; ++k){
+        subindex[2] = index[2]*2 + k;
+        listCoreVxls(cell, list, subindex, lvl-1);
+      }
+    }
+  }
+}
+
+size_t findRoot(std::vector<size_t>& parent, size_t i){
+  while (parent[i] != i){
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+void unite(std::vector<size_t>& parent, const size_t i, const size_t j){
+  const size_t root_i = findRoot(parent, i);
+  const size_t root_j = findRoot(parent, j);
+  if (root_i < root_j){parent[root_j] = root_i;}
+  else if (root_j < root_i){parent[root_i] = root_j;}
+}
@@ -0,0 +1,89 @@
+#include "sparsegrid.h"
+#include <stdexcept>
+#include <algorithm>
+
+/////////////////
+// CONSTRUCTOR //
+/////////////////
+
+SparseGrid::SparseGrid(const std::array<unsigned long,3>& n_top_vxl, const int max_depth)
+  : _n_top_vxl(n_top_vxl), _max_depth(max_depth), _top_types(n_top_vxl), _top_ids(n_top_vxl), _top_subvoxels(n_top_vxl) {
+  for (unsigned long i = 0; i < n_top_vxl[0]*n_top_vxl[1]*n_top_vxl[2]; ++i){
+    _top_subvoxels.getElement(i) = s_no_subvoxels;
+  }
+  for (int lvl = 0; lvl < max_depth; ++lvl){
+    const uint64_t n_vxl_on_lvl = (uint64_t(n_top_vxl[0]) * n_top_vxl[1] * n_top_vxl[2]) << (3*(max_depth-lvl));
+    _pools.push_back(std::make_unique<Pool>(n_vxl_on_lvl));
+  }
+}
+
+SparseGrid::Pool::Pool(const uint64_t max_vxl){
+  // no more chunks than needed for a dense level or than can be addressed by brick ids
+  const uint64_t max_chunks = std::min((max_vxl >> s_chunk_bits) + 1, (uint64_t(s_no_subvoxels) * 8) >> s_chunk_bits);
+  _chunks.resize(max_chunks);
+}
+
+////////////
+// ACCESS //
+////////////
+
+void SparseGrid::allocateSubvoxels(const std::array<unsigned,3>& index, const int lvl, const char type){
+  if (lvl == 0){return;}
+  const Slot slot = findSlot(index, lvl);
+  if (getSubvoxels(slot) != s_no_subvoxels){return;}
+  const Cavity::id_type id = getID(slot);
+  Pool& pool = *_pools[lvl-1];
+  const uint32_t brick = pool.allocateBrick();
+  for (uint64_t pos = uint64_t(brick)*8; pos < uint64_t(brick)*8 + 8; ++pos){
+    pool.getVoxel(pos).setType(type);
+    pool.getID(pos) = id;
+    pool.getSubvoxels(pos) = s_no_subvoxels;
+  }
+  getSubvoxels(slot) = brick;
+}
+
+void SparseGrid::readRow(const int lvl, const unsigned y, const unsigned z, const unsigned x_begin, const unsigned x_end,
+    Voxel* types, Cavity::id_type* ids) const {
+  unsigned x = x_begin;
+  while (x < x_end){
+    const Slot slot = findSlot(std::array<unsigned,3>({x,y,z}), lvl);
+    // a pure voxel covers all voxels of the row up to its border
+    const int n_sublvl = slot.lvl - lvl;
+    const unsigned x_border = std::min(x_end, ((x >> n_sublvl) + 1) << n_sublvl);
+    const Voxel& vxl = getVoxel(slot);
+    const Cavity::id_type id = getID(slot);
+    for (; x < x_border; ++x){
+      types[x] = vxl;
+      if (ids){ids[x] = id;}
+    }
+  }
+}
+
+size_t SparseGrid::getNumAllocated() const {
+  size_t n_vxl = 0;
+  for (const auto& pool : _pools){
+    n_vxl += pool->size() * 8;
+  }
+  return n_vxl;
+}
+
+//////////
+// POOL //
+//////////
+
+uint32_t SparseGrid::Pool::allocateBrick(){
+  std::lock_guard<std::mutex> lock(_mtx);
+  const uint64_t chunk = (_n_bricks * 8) >> s_chunk_bits;
+  if (chunk >= _chunks.size()){
+    throw std::overflow_error("Too many voxels for sparse grid!");
+  }
+  if (!_chunks[chunk]){
+    _chunks[chunk] = std::make_unique<Chunk>();
+  }
+  return _n_bricks++;
+}
+
+size_t SparseGrid::Pool::size() const {
+  std::lock_guard<std::mutex> lock(_mtx);
+  return _n_bricks;
+}
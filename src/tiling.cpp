@@ -0,0 +1,140 @@
+#include "tiling.h"
+#include <thread>
+#include <exception>
+#include <algorithm>
+
+/////////////////
+// CONSTRUCTOR //
+/////////////////
+
+TileScheduler::TileScheduler(const index_type& n_elements, const unsigned tile_edge, const unsigned n_threads)
+  : TileScheduler(n_elements, {tile_edge, tile_edge, tile_edge}, n_threads) {}
+
+TileScheduler::TileScheduler(const index_type& n_elements, const index_type& tile_size, const unsigned n_threads)
+  : _n_threads(resolveNumThreads(n_threads)), _stop(false), _n_done(0) {
+  index_type edge;
+  for (char dim = 0; dim < 3; ++dim){
+    edge[dim] = std::max(tile_size[dim], 1u);
+  }
+  // tiles are listed with x as the slowest and z as the fastest index, like the serial loops
+  Tile tile;
+  for (tile.start[0] = 0; tile.start[0] < n_elements[0]; tile.start[0] += edge[0]){
+    tile.end[0] = std::min(tile.start[0] + edge[0], n_elements[0]);
+    for (tile.start[1] = 0; tile.start[1] < n_elements[1]; tile.start[1] += edge[1]){
+      tile.end[1] = std::min(tile.start[1] + edge[1], n_elements[1]);
+      for (tile.start[2] = 0; tile.start[2] < n_elements[2]; tile.start[2] += edge[2]){
+        tile.end[2] = std::min(tile.start[2] + edge[2], n_elements[2]);
+        _tiles.push_back(tile);
+      }
+    }
+  }
+  // there is no use for more threads than tiles
+  _n_threads = std::max(1u, std::min<unsigned>(_n_threads, _tiles.size()));
+}
+
+////////////
+// ACCESS //
+////////////
+
+size_t TileScheduler::size() const {
+  return _tiles.size();
+}
+
+unsigned TileScheduler::getNumThreads() const {
+  return _n_threads;
+}
+
+const TileScheduler::Tile& TileScheduler::getTile(const size_t i) const {
+  return _tiles[i];
+}
+
+unsigned TileScheduler::resolveNumThreads(const unsigned n_threads){
+  if (n_threads != 0){return n_threads;}
+  // hardware_concurrency may return 0 if the value is not computable
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void TileScheduler::stop(){
+  _stop = true;
+}
+
+bool TileScheduler::isStopped() const {
+  return _stop;
+}
+
+////////////////
+// SCHEDULING //
+////////////////
+
+void TileScheduler::run(const std::function<void(const Tile&, const unsigned)>& work,
+    const std::function<bool(const double)>& progress){
+  _stop = false;
+  _n_done = 0;
+  if (_tiles.empty()){return;}
+
+  // hand out contiguous blocks of tiles, so that each worker starts in its own region
+  std::vector<WorkQueue> queues(_n_threads);
+  for (unsigned w = 0; w < _n_threads; ++w){
+    const size_t first = (_tiles.size() * w) / _n_threads;
+    const size_t last = (_tiles.size() * (w+1)) / _n_threads;
+    for (size_t i = first; i < last; ++i){
+      queues[w].tiles.push_back(i);
+    }
+  }
+
+  std::exception_ptr error = nullptr;
+  std::mutex error_mtx;
+
+  auto worker = [&](const unsigned thread_id){
+    size_t tile_id;
+    try {
+      while (!_stop && popTile(queues, thread_id, tile_id)){
+        work(_tiles[tile_id], thread_id);
+        const double fraction = double(++_n_done)/_tiles.size();
+        if (thread_id == 0 && progress && !progress(fraction)){
+          stop();
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(error_mtx);
+      if (!error){error = std::current_exception();}
+      stop();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned w = 1; w < _n_threads; ++w){
+    threads.emplace_back(worker, w);
+  }
+  worker(0);
+  for (std::thread& t : threads){
+    t.join();
+  }
+
+  if (error){std::rethrow_exception(error);}
+}
+
+// takes the next tile from the front of the worker's own queue. if the queue is empty, takes
+// a tile from the back of another worker's queue instead. returns false once all queues are empty
+bool TileScheduler::popTile(std::vector<WorkQueue>& queues, const unsigned thread_id, size_t& tile_id){
+  {
+    WorkQueue& own = queues[thread_id];
+    std::lock_guard<std::mutex> lock(own.mtx);
+    if (!own.tiles.empty()){
+      tile_id = own.tiles.front();
+      own.tiles.pop_front();
+      return true;
+    }
+  }
+  for (unsigned i = 1; i < queues.size(); ++i){
+    WorkQueue& victim = queues[(thread_id + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mtx);
+    if (!victim.tiles.empty()){
+      tile_id = victim.tiles.back();
+      victim.tiles.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
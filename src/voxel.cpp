@@ -2,7 +2,8 @@
 #include "space.h"
 #include "misc.h"
 #include "atom.h"
-#include "controller.h"
+#include "distancetransform.h"
+#include "profile.h"
 #include <cmath> // abs, pow
 #include <algorithm> // max_element, swap
 #include <cassert>
@@ -12,134 +13,57 @@
 // AUX FUNCTIONS //
 ///////////////////
 
-inline double Voxel::calcVxlRadius(const double& max_depth){
-  return max_depth != 0 ? 0.86602540378 * s_cell->getVxlSize() * (pow(2,max_depth) - 1) : 0;
-}
 char mergeTypes(std::vector<Voxel*>&);
 char mergeTypes(const std::array<char,8>&);
 
-/////////////////////////
-// SEARCH INDEX STRUCT //
-/////////////////////////
-// this struct is used to store the relative indices of neighbour voxels in increasing distance,
-// as well as the upper search distance limits for every level. this only needs to be created once
-// before the calculation
-
-// function declarations for functions used in SearchIndex initialisation
-std::vector<std::array<unsigned int,3>> sumOfThreeSquares(unsigned long int);
-std::vector<std::array<int,3>> logPermutations(const std::array<unsigned int,3>);
-void signCombinations(std::vector<std::array<int,3>>&, std::array<int,3>);
-void signCombinations(std::vector<std::array<int,3>>&, std::array<unsigned int,3>);
-
-// constructors
-SearchIndex::SearchIndex(){}
-
-SearchIndex::SearchIndex(const double r_probe, const double grid_size, const unsigned int max_depth){
-  _safe_lim = std::vector<unsigned int>(max_depth+1);
-  _upp_lim = std::vector<unsigned int>(max_depth+1);
-  for (unsigned int lvl = 0; lvl <= max_depth; ++lvl){
-    // maximum distance between neighbour voxels that need to be assessed (in units of voxel side length at lvl)
-    double max_dist = r_probe/(grid_size*std::pow(2,lvl)) + std::sqrt(2)/4;
-    // voxel radius in units of voxel side length at current lvl
-    double vxl_radius = std::sqrt(3) * (1-1/std::pow(2,lvl));
-    // squared max distance between neighbours, where voxels do not have to be split
-    _safe_lim[lvl] = (0 > max_dist - 2*vxl_radius)? 0 : std::pow( max_dist - (2*vxl_radius) , 2);
-    // squared max distance between neighbours, that need to be assessed
-    _upp_lim[lvl] = std::pow( max_dist + 2*vxl_radius , 2);
-  }
-  unsigned int max_element = *std::max_element(_upp_lim.begin(), _upp_lim.end());
-  _index_list = computeIndices(max_element);
-}
-
-// access
-const std::vector<std::array<int,3>>& SearchIndex::operator[](unsigned int i){
-  return _index_list[i];
-}
-
-unsigned int SearchIndex::getUppLim(unsigned int lvl){
-  return _upp_lim[lvl];
-}
-
-unsigned int SearchIndex::getSafeLim(unsigned int lvl){
-  return _safe_lim[lvl];
-}
+///////////////////
+// CORE SNAPSHOT //
+///////////////////
 
-// initialisation of indices
-std::vector<std::vector<std::array<int,3>>> SearchIndex::computeIndices(unsigned int upp_lim){
-  std::vector<std::vector<std::array<int,3>>> search_indices = std::vector<std::vector<std::array<int,3>>>(upp_lim+1);
-  for (unsigned int n = 0; n <= upp_lim; n++){
-    // get all combinations of three integers whose sum equals n
-    std::vector<std::array<unsigned int,3>> list_of_roots = sumOfThreeSquares(n);
-    for (std::array<unsigned int,3> roots : list_of_roots){
-      // get all sign combinations for each integer combination
-      std::vector<std::array<int,3>> temp = logPermutations(roots);
-      search_indices[n].insert(std::end(search_indices[n]), std::begin(temp), std::end(temp));
-    }
+CoreSnapshot::CoreSnapshot(const std::vector<std::array<unsigned long,3>>& n_vxl, const unsigned char core_bit)
+  : _n_vxl(n_vxl), _core_bit(core_bit) {
+  for (const std::array<unsigned long,3>& n : n_vxl){
+    _bits.push_back(std::vector<uint64_t>((n[0]*n[1]*n[2] + 31)/32, 0));
   }
-  return search_indices;
+  _types = {0, char(0b10000000 | (1 << core_bit)), 0b00001001};
 }
 
-std::vector<std::vector<std::array<int,3>>> SearchIndex::computeIndices(unsigned int upp_lim, const bool include_zero){
-  std::vector<std::vector<std::array<int,3>>> indices = computeIndices(upp_lim);
-  if (!include_zero){
-    indices.erase(indices.begin());
+// not thread safe, since neighbouring voxels share the same word
+void CoreSnapshot::setType(const unsigned lvl, const unsigned long i, const char type){
+  uint64_t state = 0;
+  if (readBit(type, _core_bit)){
+    state = (type == _types[2])? 2 : 1;
   }
-  return indices;
+  _bits[lvl][i >> 5] |= state << ((i & 31) * 2);
 }
 
-// list all unique combinations of three integers, whose sum added results in n
-std::vector<std::array<unsigned int,3>> sumOfThreeSquares(unsigned long int n){
-  std::vector<std::array<unsigned int,3>> list_of_roots;
-  for (unsigned int x = 0; x <= std::sqrt(n); x++){
-    unsigned int diff = n - std::pow(x,2);
-    for (unsigned int y = x; y <= std::sqrt(diff); y++){
-      unsigned int z_sqr = diff - pow(y,2);
-      unsigned int z = std::sqrt(z_sqr);
-      if (z_sqr == std::pow(z,2) && z >= y){
-        list_of_roots.push_back({x,y,z});
-      }
-    }
-  }
-  return list_of_roots;
-}
+////////////////////
+// CORE DISTANCES //
+////////////////////
 
-// given an array of size three, return all permutations of those three numbers
-std::vector<std::array<int,3>> logPermutations(const std::array<unsigned int,3> inp_arr){
-  std::vector<std::array<int,3>> list;
-  signCombinations(list, inp_arr); // initial order
-  for (int i = 0; i < 2; i++){
-    for (int j = i+1; j < ((inp_arr[1]==inp_arr[2])? 2 : 3); j++){
-      std::array<unsigned int,3> arr = inp_arr;
-      if (arr[i] != arr[j]){ // if i and j are different, swap and store
-        std::swap(arr[i], arr[j]);
-        signCombinations(list, arr);
-        if (i!=1 && arr[1]!=arr[2]){ // if 1 and 2 are different, swap and store
-          std::swap(arr[1], arr[2]);
-          signCombinations(list, arr);
-        }
-      }
+CoreDistances::CoreDistances(const CoreSnapshot& snapshot) : _n_vxl(snapshot.getGridsteps()) {
+  for (unsigned lvl = 0; lvl < _n_vxl.size(); ++lvl){
+    const std::array<unsigned long,3>& n = _n_vxl[lvl];
+    std::vector<uint16_t> sq_dist(n[0]*n[1]*n[2]);
+    for (unsigned long i = 0; i < sq_dist.size(); ++i){
+      sq_dist[i] = snapshot.hasCore(lvl, i)? 0 : s_max_sq_dist;
     }
+    squaredDistanceTransform(sq_dist, n);
+    _sq_dist.push_back(std::move(sq_dist));
   }
-  return list;
 }
 
-// to a vector, append all sign combinations of the number in an array of size 3
-void signCombinations(std::vector<std::array<int,3>>& list, std::array<int,3> arr){
-  // following two lines check whether any element is zero
-  for (int sign = 0; sign < ((arr[2]==0)? 4 : 8); sign += ((arr[0]==0)? 2 : 1)){ // loop over sign combinations
-    if (arr[1]==0 && sign%4 > 1){continue;} // skip if middle element is 0
-    list.push_back({
-      static_cast<int>((pow(-1, sign    %2))*arr[0]),
-      static_cast<int>((pow(-1,(sign/2) %2))*arr[1]),
-      static_cast<int>((pow(-1,(sign/4) %2))*arr[2])
-    });
+unsigned CoreDistances::firstShell(const std::array<unsigned,3>& index, const unsigned lvl, const unsigned n_first) const {
+  const std::array<unsigned long,3>& n = _n_vxl[lvl];
+  const unsigned sq_dist = _sq_dist[lvl][(index[2] * n[1] + index[1]) * n[0] + index[0]];
+  if (sq_dist <= n_first){return n_first;}
+  // shell n reaches floor(sqrt(n)) voxels along each axis, so all shells below (margin+1)^2
+  // lie inside of the grid
+  unsigned long margin = index[0];
+  for (char i = 0; i < 3; ++i){
+    margin = std::min(margin, std::min<unsigned long>(index[i], n[i]-1-index[i]));
   }
-}
-
-void signCombinations(std::vector<std::array<int,3>>& list, std::array<unsigned int,3> inp_arr){
-  std::array<int,3> arr;
-  for (char i = 0; i < 3; i++){arr[i] = int(inp_arr[i]);}
-  signCombinations(list, arr);
+  return std::max<unsigned long>(n_first, std::min<unsigned long>(sq_dist, (margin+1)*(margin+1)));
 }
 
 /////////////////
@@ -148,7 +72,6 @@ void signCombinations(std::vector<std::array<int,3>>& list, std::array<unsigned
 
 Voxel::Voxel(){
   _type = 0;
-  _identity = 0;
 }
 
 ////////////
@@ -184,10 +107,6 @@ bool Voxel::isAssigned(){return readBit(_type,0);}
 char Voxel::getType() const {return _type;}
 void Voxel::setType(char input){_type = input;}
 
-// ID
-void Voxel::setID(unsigned char id){_identity = id;}
-unsigned char Voxel::getID() const {return _identity;}
-
 /////////////////////////////////
 // TYPE ASSIGNMENT PREPARATION //
 /////////////////////////////////
@@ -195,6 +114,7 @@ unsigned char Voxel::getID() const {return _identity;}
 // function to call before beginning the type assignment routine in order to prepare static variables
 void Voxel::prepareTypeAssignment(Space* cell, std::vector<Atom>& atoms){
   s_cell = cell;
+  s_progress = &cell->getProgressToken();
   delete s_atomtree;
   s_atomtree = new AtomTree(atoms);
 }
@@ -209,16 +129,36 @@ void Voxel::storeProbe(const double r_probe, const bool masking_mode){
 ///////////////////////////////
 // part of the type assigment routine. first evaluation is only concerned with the relation between
 // voxels and atoms
-char Voxel::evalRelationToAtoms(const std::array<unsigned,3>& index_vxl, Vector pos_vxl, const int lvl){
-  if(Ctrl::getInstance()->getAbortFlag()){return 0;}
+// if the close atoms of the parent voxel are given, only these atoms are considered instead of the whole tree
+char Voxel::evalRelationToAtoms(const std::array<unsigned,3>& index_vxl, Vector pos_vxl, const int lvl, const AtomBlock* parent_atoms){
+  if(s_progress->sampleAbort()){return 0;}
   if (isAssigned()) {return _type;}
+  // the subvoxels of a pure voxel carry its type until the voxel is split
+  const char subvxl_type = _type;
+  const double rad_vxl = s_cell->getLevelConstants(lvl).radius;
+
+  // one list per level and thread, so that the list of a voxel remains intact while its subvoxels are evaluated
+  thread_local std::vector<AtomBlock> close_atoms_by_lvl;
+  if (close_atoms_by_lvl.size() <= (size_t)lvl){close_atoms_by_lvl.resize(lvl+1);}
+  AtomBlock& close_atoms = close_atoms_by_lvl[lvl];
+  close_atoms.clear();
+  // the atoms of any subvoxel are within the reach of its parent. the margin keeps rounding errors from
+  // dropping an atom at the edge of the reach, because each subvoxel only searches its parent's list
+  const double reach = s_r_probe + rad_vxl + 0.01 * s_cell->getVxlSize();
+  if (parent_atoms){
+    filterAtoms(close_atoms, *parent_atoms, pos_vxl, reach);
+  }
+  else {
+    traverseTree(close_atoms, s_atomtree->getRoot(), pos_vxl, reach);
+  }
+
   if (!hasSubvoxel()) {
-    double rad_vxl = calcVxlRadius(lvl); // calculated every time, since max_depth may change (not expensive)
-    traverseTree(s_atomtree->getRoot(), s_atomtree->getMaxRad(), pos_vxl, rad_vxl, s_r_probe, lvl);
+    _type = classifyAtoms(close_atoms, pos_vxl, rad_vxl, s_r_probe, _type, s_masking_mode);
     if (_type == 0){_type = s_masking_mode? 0b00100001 : 0b00001001;}
   }
   if (hasSubvoxel()) {
-    splitVoxel(index_vxl, pos_vxl, lvl);
+    s_cell->allocateSubvoxels(index_vxl, lvl, subvxl_type);
+    splitVoxel(index_vxl, pos_vxl, lvl, close_atoms);
   }
   else {
     // voxel has been processed
@@ -230,40 +170,18 @@ char Voxel::evalRelationToAtoms(const std::array<unsigned,3>& index_vxl, Vector
 // passes parent type to all children
 void Voxel::passTypeToChildren(const std::array<unsigned,3>& index, const int lvl){
   if (lvl == 0){return;}
-  std::array<unsigned,3> sub_index;
-  for (char x = 0; x < 2; ++x){
-    sub_index[0] = index[0]*2 + x;
-    for (char y = 0; y < 2; ++y){
-      sub_index[1] = index[1]*2 + y;
-      for (char z = 0; z < 2; ++z){
-        sub_index[2] = index[2]*2 + z;
-
-        getSubvoxel(sub_index, lvl).setType(_type);
-        getSubvoxel(sub_index, lvl).passTypeToChildren(sub_index, lvl-1);
-      }
-    }
-  }
+  s_cell->fillSubtreeType(index, lvl, _type);
 }
 
 void Voxel::passIDtoChildren(const std::array<unsigned,3>& index, const int lvl){
   if (lvl == 0){return;}
-  std::array<unsigned,3> sub_index;
-  for (char x = 0; x < 2; ++x){
-    sub_index[0] = index[0]*2 + x;
-    for (char y = 0; y < 2; ++y){
-      sub_index[1] = index[1]*2 + y;
-      for (char z = 0; z < 2; ++z){
-        sub_index[2] = index[2]*2 + z;
-
-        getSubvoxel(sub_index, lvl).setID(_identity);
-        getSubvoxel(sub_index, lvl).passIDtoChildren(sub_index, lvl-1);
-      }
-    }
-  }
+  s_cell->fillSubtreeID(index, lvl, s_cell->getID(index, lvl));
 }
 
 // adds an array of size 8 to the voxel that contains 8 subvoxels and evaluates each subvoxel's type
-void Voxel::splitVoxel(const std::array<unsigned,3>& vxl_index, const Vector& vxl_pos, const double lvl){
+void Voxel::splitVoxel(const std::array<unsigned,3>& vxl_index, const Vector& vxl_pos, const int lvl, const AtomBlock& close_atoms){
+  // the centres of the subvoxels are a quarter of the voxel's edge away from its centre in each direction
+  const double offset = s_cell->getLevelConstants(lvl).edge / 4;
   // split into 8 subvoxels
   std::array<char,8> subtypes;
   std::array<unsigned,3> sub_index;
@@ -279,9 +197,9 @@ void Voxel::splitVoxel(const std::array<unsigned,3>& vxl_index, const Vector& vx
         sub_index[0] = vxl_index[0]*2 + x;
         factors[0] = x ? 1 : -1;
         // modify position
-        Vector new_pos = vxl_pos + factors * s_cell->getVxlSize() * std::pow(2,lvl-2);
+        Vector new_pos = vxl_pos + factors * offset;
 
-        subtypes[i] = getSubvoxel(sub_index, lvl).evalRelationToAtoms(sub_index, new_pos, lvl-1);
+        subtypes[i] = getSubvoxel(sub_index, lvl).evalRelationToAtoms(sub_index, new_pos, lvl-1, &close_atoms);
         ++i;
 
       }
@@ -290,107 +208,31 @@ void Voxel::splitVoxel(const std::array<unsigned,3>& vxl_index, const Vector& vx
   setType(mergeTypes(subtypes));
 }
 
-// goes through all close atoms to determine a voxel's type
-void Voxel::traverseTree
-  (const AtomNode* node,
-   const double rad_max,
-   const Vector& pos_vxl,
-   const double rad_vxl,
-   const double rad_probe,
-   const int max_depth,
-   const char exit_type,
-   const char dim){
-
-  if (node == NULL){return;}
-  const Atom& atom = node->getAtom();
-
-  // distance between atom and voxel along one dimension
-  double dist1D = distance(atom.getPosVec(), pos_vxl, dim);
-
-  if (abs(dist1D) > (rad_vxl + rad_max + rad_probe)){ // then atom is too far to matter for voxel type
-      traverseTree(dist1D < 0 ? node->getLeftChild() : node->getRightChild(),
-          rad_max, pos_vxl, rad_vxl, rad_probe, max_depth, exit_type, (dim+1)%3);
-  }
-  else{ // then atom is close enough to influence voxel type
-    if(isAtom(atom, pos_vxl, rad_vxl, rad_probe)){return;}
-
-    // continue with both children
-    for (const AtomNode* child : {node->getLeftChild(), node->getRightChild()}){
-      traverseTree(child, rad_max, pos_vxl, rad_vxl, rad_probe, max_depth, exit_type, (dim+1)%3);
-    }
-  }
-}
-
-// assign a type based on the distance between a voxel and an atom
-bool Voxel::isAtom(const Atom& atom, const Vector& pos_vxl, const double rad_vxl, const double rad_probe){
-  Vector dist = pos_vxl - atom.getPosVec();
-
-  if((dist < atom.getRad() - rad_vxl) && (0 < atom.getRad() - rad_vxl)){ // if completely inside atom
-    _type = 0b00000011;
-    return true;
-  }
-  else if (dist < atom.getRad() + rad_vxl){ // if partially inside atom
-    if (readBit(_type,1)){return false;} // if inside atom // TODO: this line may be unnecessary
-    _type = 0b10000010;
-  }
-  else if ((dist < atom.getRad() + rad_probe - rad_vxl) && (0 < atom.getRad() + rad_probe - rad_vxl)){ // if outside atom but not touching potential probe core
-    if (readBit(_type,1)){return false;} // if mixed or inside atom
-    _type = s_masking_mode? 0b01000000 : 0b00010000;
-  }
-  else if (dist < atom.getRad() + rad_probe + rad_vxl){ // if outside atom but touching potential probe core
-    if (readBit(_type,4) || readBit(_type,1)){return false;} // if mixed, inside atom, or potential shell
-    _type = s_masking_mode? 0b11000000 : 0b10010000;
-  }
-  return false;
-}
-
-// TODO: Remove, instead use AtomTree::listAllWithin()
-// go through a tree, starting from node. return a list of atoms that are a specified max distance
-// from a point with radius rad_point.
-void Voxel::listFromTree(
-  std::vector<int>& atom_id_list,
-  const AtomNode* node,
-  const Vector& pos_point,
-  const double& rad_point,
-  const double& rad_max, // ideally this value should be retrieved from node
-  const double& max_dist,
-  const char dim)
-{
-  if (node == NULL){return;}
+// goes through the tree and lists all atoms whose surface is closer to the voxel's centre than the reach.
+// the atoms are listed in the order in which the tree is traversed, with each node before its
+// children. this is the order in which the atoms are evaluated, which matters in masking mode
+void Voxel::traverseTree(AtomBlock& close_atoms, const AtomTree::Range& range, const Vector& pos_vxl, const double reach){
+  if (range.empty()){return;}
+  const size_t node = range.node();
+  if (ProfileCounts* counts = Profiler::counts()){counts->tree_nodes++;}
 
-  // distance between atom and point along one dimension
-  double dist1D = distance(node->getAtom().getPosVec(), pos_point, dim);
-  double rad_atom = node->getAtom().getRad();
+  // no atom of the subtree is close enough
+  const double reach_subtree = s_atomtree->getSubtreeMaxRad(node) + reach;
+  if (!(s_atomtree->squaredDistToBox(node, pos_vxl) < reach_subtree*reach_subtree)){return;}
 
-  if (abs(dist1D) > rad_point + rad_max + max_dist) { // then atom is too far
-      listFromTree(atom_id_list, dist1D<0? node->getLeftChild() : node->getRightChild(), pos_point, rad_point, rad_max, max_dist, (dim+1)%3);
-  }
-  else { // then atom may be close enough
-    if ((pos_point-node->getAtom().getPosVec()) < rad_point + rad_atom + max_dist){
-      atom_id_list.push_back(node->getAtomId());
-    }
-
-    // continue with both children
-    for (const AtomNode* child : {node->getLeftChild(), node->getRightChild()}){
-      listFromTree(atom_id_list, child, pos_point, rad_point, rad_max, max_dist, (dim+1)%3);
-    }
+  const double reach_node = s_atomtree->getRad(node) + reach;
+  const Vector pos_node = s_atomtree->getPosVec(node);
+  if (pos_vxl - pos_node < reach_node){
+    close_atoms.push_back(pos_node, s_atomtree->getRad(node));
   }
+  traverseTree(close_atoms, range.left(), pos_vxl, reach);
+  traverseTree(close_atoms, range.right(), pos_vxl, reach);
 }
 
 ///////////////
 // CAVITY ID //
 ///////////////
 
-struct VoxelLoc{
-  VoxelLoc() = default;
-  VoxelLoc(const std::array<unsigned,3>& index, const int lvl) : index(index), lvl(lvl), interface_vxl(false) {}
-  VoxelLoc(const std::array<unsigned,3>& index, const int lvl, const bool interface_vxl)
-    : index(index), lvl(lvl), interface_vxl(interface_vxl) {}
-  std::array<unsigned,3> index;
-  int lvl;
-  bool interface_vxl;
-};
-
 class FloodStack{
   private:
     std::vector<VoxelLoc> economy_lane;
@@ -423,13 +265,13 @@ class FloodStack{
 
 // this function returns false when accessing an existing cavity and returns
 // true every time a new cavity has been processed
-bool Voxel::floodFill(std::vector<Cavity>& cavities, const unsigned char id, const std::array<unsigned,3>& start_index, const int start_lvl, const bool cavity_type){
-  if(getID() != 0){return false;}
+bool Voxel::floodFill(std::vector<Cavity>& cavities, const Cavity::id_type id, const std::array<unsigned,3>& start_index, const int start_lvl, const bool cavity_type){
+  if(s_cell->getID(start_index, start_lvl) != 0){return false;}
   // initialise flood fill stack
   FloodStack stack;
 
   // set the ID of the start voxel and all its children
-  setID(id);
+  s_cell->setID(start_index, start_lvl, id);
   passIDtoChildren(start_index, start_lvl);
   // add first voxel to stack
   stack.pushBack(VoxelLoc(start_index, start_lvl), 
@@ -437,9 +279,10 @@ bool Voxel::floodFill(std::vector<Cavity>& cavities, const unsigned char id, con
   
   int n_interface = 0;
   bool at_interface = false;
+  size_t stack_max = 0;
   while (stack.size() > 0){
-    if (Ctrl::getInstance()->getAbortFlag()){return false;}
-    Ctrl::getInstance()->updateCalculationStatus(); // checks for abort button click
+    if (s_progress->sampleAbort()){return false;}
+    stack_max = std::max(stack_max, stack.size());
 
     // get the next voxel from the stack
     VoxelLoc vxl = stack.popOut();
@@ -450,12 +293,10 @@ bool Voxel::floodFill(std::vector<Cavity>& cavities, const unsigned char id, con
    
     // go through all neighbours
     for (const VoxelLoc& nb_loc : all_core_nbs){
-      // get a reference to the neighbour voxel
-      Voxel& nb_vxl = s_cell->getVxlFromGrid(nb_loc.index,nb_loc.lvl);
-      if (nb_vxl.getID()){continue;} // skip processed voxels
+      if (s_cell->getID(nb_loc.index, nb_loc.lvl)){continue;} // skip processed voxels
       
-      nb_vxl.setID(id);
-      nb_vxl.passIDtoChildren(nb_loc.index, nb_loc.lvl);
+      s_cell->setID(nb_loc.index, nb_loc.lvl, id);
+      s_cell->getVxlFromGrid(nb_loc.index,nb_loc.lvl).passIDtoChildren(nb_loc.index, nb_loc.lvl);
       stack.pushBack(nb_loc, cavity_type? isInterfaceVxl(nb_loc) : false);
     }
     
@@ -467,10 +308,19 @@ bool Voxel::floodFill(std::vector<Cavity>& cavities, const unsigned char id, con
     // determines whether we are at a core-outside interface
     at_interface = stack.sizePriority();
   }
+  if (ProfileCounts* counts = Profiler::counts()){
+    counts->flood_stack_max = std::max<uint64_t>(counts->flood_stack_max, stack_max);
+  }
   cavities.push_back(Cavity(id, n_interface));
   return true;
 }
 
+// returns all pure core neighbours regardless of their id. used to find connected cavities
+// without flood filling them
+std::vector<VoxelLoc> Voxel::findCoreNeighbours(const VoxelLoc& central_vxl){
+  return findPureNeighbours(central_vxl, mvTYPE_SP_CORE, true);
+}
+
 bool Voxel::isInterfaceVxl(const VoxelLoc& vxl){
   std::vector<VoxelLoc> outside_nbs = s_cell->getVxlFromGrid(vxl.index, vxl.lvl).findPureNeighbours(vxl, mvTYPE_LP_SHELL);
   // if (nbs.size()){return true;}
@@ -501,7 +351,7 @@ std::vector<VoxelLoc> Voxel::findPureNeighbours(const VoxelLoc& central_vxl, con
       if (!s_cell->isInBounds(nb_index,central_vxl.lvl)){continue;}
 
       Voxel& nb_vxl = s_cell->getVxlFromGrid(nb_index,central_vxl.lvl);
-      if (!any_id && nb_vxl.getID()){continue;} // greatly accelerates flood fill
+      if (!any_id && s_cell->getID(nb_index,central_vxl.lvl)){continue;} // greatly accelerates flood fill
       if (!(nb_vxl.getType() & type_flag)){continue;}
 
       if (nb_vxl.hasSubvoxel()){
@@ -530,21 +380,24 @@ void Voxel::descend(std::vector<VoxelLoc>& all_pure_nbs, const std::array<unsign
     // the subvoxels that need to be added to the flood fill stack are determined by the relation of the previous
     // voxel and the current voxel. the following block evaluates the relation to determine, which subvoxels to
     // loop through
-    std::array<std::vector<char>,3> loop_i;
+    std::array<char,3> loop_first;
+    std::array<char,3> loop_last;
     for (char dim = 0; dim < 3; ++ dim){
       if (nb_relation[dim]){
-        loop_i[dim] = {static_cast<char>((nb_relation[dim] > 0)? 0 : 1)};
+        loop_first[dim] = (nb_relation[dim] > 0)? 0 : 1;
+        loop_last[dim] = loop_first[dim];
       }
       else {
-        loop_i[dim] = {0,1};
+        loop_first[dim] = 0;
+        loop_last[dim] = 1;
       }
     }
 
-    for (char i : loop_i[0]){
+    for (char i = loop_first[0]; i <= loop_last[0]; ++i){
       sub_index[0] = index[0] * 2 + i;
-      for (char j : loop_i[1]){
+      for (char j = loop_first[1]; j <= loop_last[1]; ++j){
         sub_index[1] = index[1] * 2 + j;
-        for (char k : loop_i[2]){
+        for (char k = loop_first[2]; k <= loop_last[2]; ++k){
           sub_index[2] = index[2] * 2 + k;
           s_cell->getVxlFromGrid(sub_index, lvl-1).descend(all_pure_nbs, sub_index, lvl-1, nb_relation, type_flag);
         }
@@ -590,10 +443,12 @@ void Voxel::ascend(std::vector<VoxelLoc>& all_pure_nbs, const std::array<unsigne
 
 char Voxel::evalRelationToVoxels(const std::array<unsigned int,3>& index, const unsigned lvl, bool split){
   // if voxel (including all subvoxels) have been assigned, then return immediately
-  if (Ctrl::getInstance()->getAbortFlag()){return 0;}
+  if (s_progress->sampleAbort()){return 0;}
   if (isAssigned()){return _type;}
   else if (!hasSubvoxel()){ // vxl has no children
+    const char subvxl_type = _type;
     split = !searchForCore(index, lvl, split);
+    if (hasSubvoxel()){s_cell->allocateSubvoxels(index, lvl, subvxl_type);}
   }
   if (hasSubvoxel()) { // vxl has children
     std::array<unsigned int,3> index_subvxl;
@@ -616,6 +471,20 @@ char Voxel::evalRelationToVoxels(const std::array<unsigned int,3>& index, const
   return _type;
 }
 
+// while a snapshot is set, neighbour types are read from the snapshot instead of the grid.
+// the shell vs void evaluation never changes the core bits, so the result is the same
+void Voxel::setCoreSnapshot(const CoreSnapshot* snapshot){
+  s_core_snapshot = snapshot;
+}
+
+void Voxel::setCoreDistances(const CoreDistances* distances){
+  s_core_distances = distances;
+}
+
+unsigned char Voxel::getCoreBit(){
+  return s_masking_mode? 5 : 3;
+}
+
 bool Voxel::searchForCore(const std::array<unsigned int,3>& index, const unsigned lvl, bool split){
   // the return value of this function is used to determine, whether after splitting this voxel,
   // the subsequent neighbour search should start from 0 or from the safe limit. The use of this
@@ -625,25 +494,32 @@ bool Voxel::searchForCore(const std::array<unsigned int,3>& index, const unsigne
   _type = s_masking_mode? 0 : 0b00000101; // type excluded
 
   const char shell_type = s_masking_mode? 0b01000001 : 0b00010001;
-  const char bit_pos_core = s_masking_mode? 5 : 3;
-
-  for (unsigned int n = (split? Voxel::s_search_indices.getSafeLim(lvl+1)*4 : 1); n <= Voxel::s_search_indices.getUppLim(lvl); ++n){
+  const char bit_pos_core = getCoreBit();
+
+  unsigned int n_first = split? Voxel::s_search_indices.getSafeLim(lvl+1)*4 : 1;
+  // skip the shells that are closer than the closest core
+  if (s_core_distances){n_first = s_core_distances->firstShell(index, lvl, n_first);}
+  // counts the shells from n_first to n_last
+  auto countShells = [n_first](const unsigned int n_last){
+    if (ProfileCounts* counts = Profiler::counts()){counts->shells_scanned += (n_last >= n_first)? n_last - n_first + 1 : 0;}
+  };
+  for (unsigned int n = n_first; n <= Voxel::s_search_indices.getUppLim(lvl); ++n){
     // called very often; keep section inexpensive
     for (std::array<int,3> coord : Voxel::s_search_indices[n]){
       coord = add(coord,index);
+      const char nb_type = s_core_snapshot? s_core_snapshot->getType(coord, lvl) : s_cell->getVxlFromGrid(coord,lvl).getType();
       // if a neighbour voxel containing a probe core is found
-      if (readBit((s_cell->getVxlFromGrid(coord,lvl)).getType(),bit_pos_core)){
-        Voxel& nb_vxl = s_cell->getVxlFromGrid(coord,lvl);
+      if (readBit(nb_type,bit_pos_core)){
         // if the neighbour is within a safe distance
         if (n <= Voxel::s_search_indices.getSafeLim(lvl)){
           next_search_from_0 = true;
           setType(shell_type); // TODO: type is set only to be potentially reset
-          if (!s_masking_mode && nb_vxl.getType() != 0b00001001){
+          if (!s_masking_mode && nb_type != 0b00001001){
             setType(0b10000000);
           }
           else {
             // voxel evaluation successful
-            setID(nb_vxl.getID());
+            s_cell->setID(index, lvl, s_cell->getID(coord,lvl));
             passIDtoChildren(index, lvl);
           }
         }
@@ -652,10 +528,12 @@ bool Voxel::searchForCore(const std::array<unsigned int,3>& index, const unsigne
           next_search_from_0 = false;
           setType(0b10000000);
         }
+        countShells(n);
         return next_search_from_0;
       }
     }
   }
+  countShells(Voxel::s_search_indices.getUppLim(lvl));
   return next_search_from_0;
 }
 
@@ -664,10 +542,10 @@ bool Voxel::searchForCore(const std::array<unsigned int,3>& index, const unsigne
 ///////////
 
 void Voxel::tallyVoxelsOfType(std::map<char,double>& type_tally,
-    std::map<unsigned char,double>& id_core_tally,
-    std::map<unsigned char,double>& id_shell_tally,
-    std::map<unsigned char,std::array<unsigned,3>>& id_min,
-    std::map<unsigned char,std::array<unsigned,3>>& id_max,
+    std::map<Cavity::id_type,double>& id_core_tally,
+    std::map<Cavity::id_type,double>& id_shell_tally,
+    std::map<Cavity::id_type,std::array<unsigned,3>>& id_min,
+    std::map<Cavity::id_type,std::array<unsigned,3>>& id_max,
     const std::array<unsigned,3>& index,
     const int lvl,
     const double vxl_fraction)
@@ -690,25 +568,27 @@ void Voxel::tallyVoxelsOfType(std::map<char,double>& type_tally,
   }
   else {
     // tally number of bottom level voxels
-    type_tally[getType()] += pow(pow2(lvl),3) * vxl_fraction;
+    const Cavity::id_type id = s_cell->getID(index, lvl);
+    const double n_bot_lvl_vxl = s_cell->getLevelConstants(lvl).n_bot_lvl_vxl;
+    type_tally[getType()] += n_bot_lvl_vxl * vxl_fraction;
     if(getType() == 0b00001001){
-      id_core_tally[getID()] += pow(pow2(lvl),3) * vxl_fraction;
+      id_core_tally[id] += n_bot_lvl_vxl * vxl_fraction;
     }
     else if(getType() == 0b00010001){
-      id_shell_tally[getID()] += pow(pow2(lvl),3) * vxl_fraction;
+      id_shell_tally[id] += n_bot_lvl_vxl * vxl_fraction;
     }
     // localise cavities
     std::array<unsigned,3> min;
     std::array<unsigned,3> max;
     for (char i = 0; i < 3; i++){
-      min[i] = index[i]*pow2(lvl);
-      max[i] = ((index[i]+1)*pow2(lvl))-1;
+      min[i] = index[i] << lvl;
+      max[i] = ((index[i]+1) << lvl) - 1;
     }
-    if (id_min.count(getID()) == 0) {id_min[getID()] = min;}
-    if (id_max.count(getID()) == 0) {id_max[getID()] = max;}
+    if (id_min.count(id) == 0) {id_min[id] = min;}
+    if (id_max.count(id) == 0) {id_max[id] = max;}
     for (char i = 0; i < 3; i++){
-      if (id_min[getID()][i] > min[i]) {id_min[getID()][i] = min[i];}
-      if (id_max[getID()][i] < max[i]) {id_max[getID()][i] = max[i];}
+      if (id_min[id][i] > min[i]) {id_min[id][i] = min[i];}
+      if (id_max[id][i] < max[i]) {id_max[id][i] = max[i];}
     }
   }
 }
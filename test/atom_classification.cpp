@@ -0,0 +1,94 @@
+#include "atomclassify.h"
+#include "misc.h"
+#include <vector>
+#include <random>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+// evaluates the atoms one after the other, as voxels were classified before batching
+char classifySequentially(const AtomBlock& block, const Vector& pos_vxl, const double rad_vxl, const double rad_probe,
+    char type, const bool masking_mode){
+  for (size_t i = 0; i < block.size(); i++){
+    const Vector dist = pos_vxl - Vector(block.pos[0][i], block.pos[1][i], block.pos[2][i]);
+    const double rad = block.rad[i];
+    if ((dist < rad - rad_vxl) && (0 < rad - rad_vxl)){
+      return 0b00000011;
+    }
+    else if (dist < rad + rad_vxl){
+      if (readBit(type,1)){continue;}
+      type = 0b10000010;
+    }
+    else if ((dist < rad + rad_probe - rad_vxl) && (0 < rad + rad_probe - rad_vxl)){
+      if (readBit(type,1)){continue;}
+      type = masking_mode? 0b01000000 : 0b00010000;
+    }
+    else if (dist < rad + rad_probe + rad_vxl){
+      if (readBit(type,4) || readBit(type,1)){continue;}
+      type = masking_mode? 0b11000000 : 0b10010000;
+    }
+  }
+  return type;
+}
+
+int main() {
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> coord(-4, 4);
+  std::uniform_real_distribution<double> radius(1.0, 2.0);
+  const std::vector<AtomKernel> kernels = {AtomKernel::scalar, AtomKernel::avx2, AtomKernel::avx512};
+  const std::vector<char> start_types = {0b00000000, 0b00010000, 0b01000000, (char)0b10000010};
+
+  // TEST: The scalar kernel is always available
+  REQUIRE(isKernelSupported(AtomKernel::scalar));
+  REQUIRE(isKernelSupported(bestAtomKernel()));
+
+  // TEST: Every supported kernel gives the same type as evaluating the atoms one by one,
+  // for blocks that are shorter than, equal to and longer than the simd width
+  {
+    bool all_equal = true;
+    bool all_relations = true;
+    std::vector<int> n_types(256, 0);
+    for (int trial = 0; trial < 2000; trial++){
+      AtomBlock block;
+      const size_t n_atoms = trial % 23;
+      for (size_t i = 0; i < n_atoms; i++){
+        block.push_back(Vector(coord(gen), coord(gen), coord(gen)), radius(gen));
+      }
+      const Vector pos_vxl(coord(gen), coord(gen), coord(gen));
+      const double rad_vxl = 0.1 * (1 + trial % 4);
+      const double rad_probe = 1.2;
+      for (bool masking_mode : {false, true}){
+        for (char type : start_types){
+          const char expected = classifySequentially(block, pos_vxl, rad_vxl, rad_probe, type, masking_mode);
+          n_types[(unsigned char)expected]++;
+          for (AtomKernel kernel : kernels){
+            if (!isKernelSupported(kernel)){continue;}
+            all_equal &= classifyAtoms(block, pos_vxl, rad_vxl, rad_probe, type, masking_mode, kernel) == expected;
+          }
+        }
+      }
+    }
+    // make sure that the random atoms actually produce every possible result
+    for (int type : {0b00000000, 0b00000011, 0b10000010, 0b00010000, 0b10010000, 0b01000000, 0b11000000}){
+      all_relations &= n_types[type] > 0;
+    }
+    REQUIRE(all_equal);
+    REQUIRE(all_relations);
+  }
+
+  // TEST: In masking mode, the last shell or touching atom decides the type
+  {
+    AtomBlock block;
+    block.push_back(Vector(0.0, 0.0, 0.0), 1.0); // shell
+    block.push_back(Vector(3.6, 0.0, 0.0), 1.0); // touching
+    const Vector pos_vxl(1.6, 0.0, 0.0);
+    for (AtomKernel kernel : kernels){
+      if (!isKernelSupported(kernel)){continue;}
+      REQUIRE((classifyAtoms(block, pos_vxl, 0.1, 1.0, 0, true, kernel) == (char)0b11000000));
+      REQUIRE((classifyAtoms(block, pos_vxl, 0.1, 1.0, 0, false, kernel) == (char)0b00010000));
+    }
+  }
+
+  return 0;
+}
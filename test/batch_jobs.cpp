@@ -0,0 +1,110 @@
+#include "batch.h"
+#include <string>
+#include <sstream>
+#include <vector>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+static std::vector<std::string> readLines(const std::string& text){
+  std::vector<std::string> lines;
+  std::istringstream ss(text);
+  std::string line;
+  while (std::getline(ss, line)){
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+int main() {
+
+  const std::string isobutane = std::string(MOLOVOL_INPUT_DIR) + "/isobutane.xyz";
+  const std::string required = "\"radius\":1.2,\"grid\":0.2";
+  const std::string elements = std::string(MOLOVOL_INPUT_DIR) + "/elements.txt";
+
+  // TEST: The keys of a job are read into the calculation parameters
+  {
+    BatchJob job;
+    std::string error;
+    REQUIRE(parseBatchJob(" {\"id\":\"a\\\"b\", \"file-structure\":\"x.pdb\", \"radius\":1.5, \"radius2\":4,"
+        " \"grid\":0.25, \"depth\":3, \"threads\":2, \"hetatm\":true, \"surface\":true,"
+        " \"radii\":{\"C\":2, \"O\":1.5}, \"elements\":[\"C\",\"O\"]} ", job, error));
+    REQUIRE((job.id == "a\"b"));
+    REQUIRE((job.param.atom_file_path == "x.pdb"));
+    REQUIRE((job.param.r_probe1 == 1.5));
+    REQUIRE((job.param.r_probe2 == 4));
+    REQUIRE(job.param.probe_mode);
+    REQUIRE((job.param.grid_step == 0.25));
+    REQUIRE((job.param.max_depth == 3));
+    REQUIRE((job.param.n_threads == 2));
+    REQUIRE(job.param.inc_hetatm);
+    REQUIRE(job.param.calc_surface_areas);
+    REQUIRE(!job.param.analyze_unit_cell);
+    REQUIRE((job.param.radius_map.at("C") == 2));
+    REQUIRE((job.param.included_elements == std::vector<std::string>{"C", "O"}));
+  }
+
+  // TEST: Invalid jobs are rejected with a description of the problem
+  {
+    BatchJob job;
+    std::string error;
+    const std::string valid = "\"file-structure\":\"x.xyz\",\"radius\":1.2,\"grid\":0.2";
+    REQUIRE(parseBatchJob("{" + valid + "}", job, error));
+    const std::vector<std::pair<std::string,std::string>> invalid_jobs = {
+      {"[]", "JSON object"},
+      {"{\"radius\":1.2,\"grid\":0.2}", "\"file-structure\" is required"},
+      {"{\"file-structure\":\"x.xyz\",\"grid\":0.2}", "\"radius\" is required"},
+      {"{\"file-structure\":\"x.xyz\",\"radius\":1.2}", "\"grid\" is required"},
+      {"{" + valid + ",\"colour\":1}", "unknown key"},
+      {"{\"file-structure\":\"x.xyz\",\"radius\":1.2,\"grid\":-1}", "\"grid\" must be"},
+      {"{" + valid + ",\"depth\":2.5}", "\"depth\" must be"},
+      {"{" + valid + ",\"depth\":21}", "\"depth\" must be an integer from 0 to 20"},
+      {"{" + valid + ",\"radius2\":1}", "\"radius2\" must not be smaller"},
+      {"{" + valid + ",\"unitcell\":true}", "pdb or cif"},
+      {"{" + valid + ",\"hetatm\":true}", "pdb or cif"},
+      {"{" + valid + "} x", "unexpected characters"},
+    };
+    for (const auto& [line, problem] : invalid_jobs){
+      error.clear();
+      REQUIRE(!parseBatchJob(line, job, error));
+      REQUIRE((error.find(problem) != std::string::npos));
+    }
+    REQUIRE(parseBatchJob("{" + valid + ",\"depth\":20}", job, error));
+    REQUIRE(parseBatchJob("{\"file-structure\":\"x.cif\",\"radius\":1.2,\"grid\":0.2,\"unitcell\":true}", job, error));
+  }
+
+  // TEST: Every job gives one result line in the order of the jobs, also when jobs fail
+  {
+    std::istringstream jobs(
+        "{\"id\":\"first\",\"file-structure\":\"" + isobutane + "\",\"file-elements\":\"" + elements + "\"," + required + ",\"depth\":3,\"surface\":true}\n"
+        "\n"
+        "{\"file-structure\":\"" + isobutane + "\",\"file-elements\":\"" + elements + "\"," + required + ",\"depth\":3,\"surface\":true}\n"
+        "not a job\n"
+        "{\"id\":4,\"file-structure\":\"" + std::string(MOLOVOL_INPUT_DIR) + "/missing.xyz\",\"file-elements\":\"" + elements + "\"," + required + "}\n"
+        "{\"id\":\"larger\",\"file-structure\":\"" + isobutane + "\",\"file-elements\":\"" + elements + "\"," + required + ",\"depth\":3,\"surface\":true,\"radii\":{\"C\":2.5}}\n");
+    std::ostringstream results;
+    REQUIRE((runBatch(jobs, results) == 2));
+    const std::vector<std::string> lines = readLines(results.str());
+    REQUIRE((lines.size() == 5));
+    REQUIRE((lines[0].rfind("{\"id\":\"first\",", 0) == 0));
+    REQUIRE((lines[0].find("\"success\":true") != std::string::npos));
+    REQUIRE((lines[0].find("\"surf_vdw\":") != std::string::npos));
+    REQUIRE((lines[0].find("\"errors\":[]") != std::string::npos));
+    // jobs without id are named by their line number
+    REQUIRE((lines[1].rfind("{\"id\":\"3\",", 0) == 0));
+    REQUIRE((lines[2].rfind("{\"id\":\"4\",", 0) == 0));
+    REQUIRE((lines[2].find("\"code\":906") != std::string::npos));
+    REQUIRE((lines[3].find("\"success\":false") != std::string::npos));
+    REQUIRE((lines[3].find("\"code\":102") != std::string::npos));
+
+    // repeated jobs give the same volumes and radii of one job do not change later jobs
+    auto volumes = [](const std::string& line){
+      const size_t begin = line.find("\"volumes\":");
+      return line.substr(begin, line.find('}', begin) - begin);
+    };
+    REQUIRE((volumes(lines[0]) == volumes(lines[1])));
+    REQUIRE((volumes(lines[0]) != volumes(lines[4])));
+  }
+
+  return 0;
+}
@@ -3,6 +3,7 @@
 #include <vector>
 #include <iostream>
 #include <map>
+#include <algorithm>
 
 // Using this macro for future compatibility with Catch2
 # define REQUIRE(x) if (!x) return -1;
@@ -42,31 +43,62 @@ int main() {
   // are arranged depends on the depth and alternates cyclically as the depth
   // increases. In this 3-d tree the first axis is the x-axis and is followed by
   // the y- then z-axis.
-  // This test checks the spatial relation between the left and right child nodes.
+  // This test checks the spatial relation between each node and its descendents.
   {
-    std::vector<const AtomNode*> treenodes;
-    std::vector<unsigned char> depth;
-
-    treenodes.push_back(atomtree.getRoot());
-    depth.push_back(0);
-
-    while (!treenodes.empty()) {
-      const AtomNode* node = treenodes[treenodes.size()-1];
-      treenodes.pop_back();
-      unsigned char d = depth[depth.size()-1];
-      depth.pop_back();
-      const AtomNode* left = node->getLeftChild();
-      const AtomNode* right = node->getRightChild();
-
-      if (left && right) {
-        if (!(left->getAtom().getCoordinate(d%3) <= right->getAtom().getCoordinate(d%3))) return -1;
-
-        treenodes.push_back(left);
-        treenodes.push_back(right);
-        depth.push_back(d+1);
-        depth.push_back(d+1);
+    std::vector<AtomTree::Range> subtrees = {atomtree.getRoot()};
+    REQUIRE((atomtree.getRoot().dim == 0));
+
+    while (!subtrees.empty()) {
+      const AtomTree::Range range = subtrees.back();
+      subtrees.pop_back();
+      if (range.empty()) continue;
+      const size_t node = range.node();
+      const char d = range.dim;
+      REQUIRE((range.left().dim == (d+1)%3));
+
+      for (size_t i = range.left().first; i < range.left().end; ++i) {
+        if (!(atomtree.getCoordinate(i, d) <= atomtree.getCoordinate(node, d))) return -1;
       }
+      for (size_t i = range.right().first; i < range.right().end; ++i) {
+        if (!(atomtree.getCoordinate(node, d) <= atomtree.getCoordinate(i, d))) return -1;
+      }
+
+      subtrees.push_back(range.left());
+      subtrees.push_back(range.right());
+    }
+  }
+
+  // TEST: Subtree bounds
+  // The bounding box of a subtree contains the centres of all its atoms and the
+  // subtree's maximum radius is the largest radius among its atoms.
+  {
+    std::vector<AtomTree::Range> subtrees = {atomtree.getRoot()};
+    while (!subtrees.empty()) {
+      const AtomTree::Range range = subtrees.back();
+      subtrees.pop_back();
+      if (range.empty()) continue;
+      const size_t node = range.node();
+      const auto box = atomtree.getBoundingBox(node);
+      double max_rad = 0;
+      for (size_t i = range.first; i < range.end; ++i) {
+        max_rad = std::max(max_rad, atomtree.getRad(i));
+        REQUIRE((atomtree.squaredDistToBox(node, atomtree.getPosVec(i)) == 0));
+        for (char dim = 0; dim < 3; ++dim) {
+          REQUIRE((box[0][dim] <= atomtree.getCoordinate(i, dim) && atomtree.getCoordinate(i, dim) <= box[1][dim]));
+        }
+      }
+      REQUIRE((atomtree.getSubtreeMaxRad(node) == max_rad));
+      subtrees.push_back(range.left());
+      subtrees.push_back(range.right());
+    }
+    // the hydrogen atoms are on the outside of the molecule, so some subtree contains only hydrogen
+    bool found_hydrogen_subtree = false;
+    for (size_t node = 0; node < atomtree.getAtomList().size(); ++node) {
+      found_hydrogen_subtree |= atomtree.getSubtreeMaxRad(node) == 1.2;
     }
+    REQUIRE(found_hydrogen_subtree);
+    // a point far away is outside of the box
+    REQUIRE((atomtree.squaredDistToBox(atomtree.getRoot().node(), Vector(100, 0, 0)) > 0));
   }
 
   std::map<std::string,int> valence = {
@@ -85,7 +117,7 @@ int main() {
     for (size_t at_id = 0; at_id < all_atoms.size(); ++at_id) {
       const Atom& at = all_atoms[at_id];
       std::vector<size_t> closest = atomtree.listAllWithin(at.getPos(), 0);
-      if (!(closest.size()-1 == valence.at(at.symbol))) return -1;
+      if (!(int(closest.size())-1 == valence.at(at.symbol))) return -1;
     }
   }
 }
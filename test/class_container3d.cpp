@@ -0,0 +1,77 @@
+#include "container3d.h"
+#include <vector>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+int main() {
+
+  // three top level blocks in x, two in y and one in z, each with 4x4x4 elements
+  const std::array<unsigned long,3> n_elements = {12,8,4};
+  const MortonLayout morton(2);
+
+  // TEST: Morton positions cover the container without gaps or overlap and can be converted back
+  {
+    std::vector<int> visits(12*8*4, 0);
+    bool roundtrip = true;
+    for (unsigned long z = 0; z < n_elements[2]; ++z){
+      for (unsigned long y = 0; y < n_elements[1]; ++y){
+        for (unsigned long x = 0; x < n_elements[0]; ++x){
+          const unsigned long pos = morton.getPos(x, y, z, n_elements);
+          if (pos >= visits.size()){return -1;}
+          visits[pos]++;
+          roundtrip &= morton.getCoord(pos, n_elements) == std::array<unsigned long,3>({x, y, z});
+        }
+      }
+    }
+    bool all_once = true;
+    for (int v : visits){all_once &= v == 1;}
+    REQUIRE(all_once);
+    REQUIRE(roundtrip);
+  }
+
+  // TEST: The subvoxels of a voxel are stored next to each other, at eight times the parent's position
+  {
+    const std::array<unsigned long,3> n_parents = {6,4,2};
+    const MortonLayout parent_morton(1);
+    bool contiguous = true;
+    for (unsigned long z = 0; z < n_elements[2]; ++z){
+      for (unsigned long y = 0; y < n_elements[1]; ++y){
+        for (unsigned long x = 0; x < n_elements[0]; ++x){
+          const unsigned long parent_pos = parent_morton.getPos(x/2, y/2, z/2, n_parents);
+          contiguous &= morton.getPos(x, y, z, n_elements) / 8 == parent_pos;
+        }
+      }
+    }
+    REQUIRE(contiguous);
+  }
+
+  // TEST: The blocks themselves are stored in row major order
+  {
+    REQUIRE((morton.getPos(4, 0, 0, n_elements) == 64));
+    REQUIRE((morton.getPos(0, 4, 0, n_elements) == 3*64));
+    REQUIRE((morton.getPos(1, 1, 1, n_elements) == 7));
+  }
+
+  // TEST: Element access is independent of the layout
+  {
+    Container3D<int> row_major(n_elements);
+    Container3D<int, MortonLayout> z_order(n_elements, morton);
+    int value = 0;
+    for (unsigned long z = 0; z < n_elements[2]; ++z){
+      for (unsigned long y = 0; y < n_elements[1]; ++y){
+        for (unsigned long x = 0; x < n_elements[0]; ++x){
+          row_major.getElement(x, y, z) = value;
+          z_order.getElement(std::array<unsigned long,3>({x, y, z})) = value;
+          value++;
+        }
+      }
+    }
+    REQUIRE((row_major.getElement(5ul, 6ul, 3ul) == z_order.getElement(5ul, 6ul, 3ul)));
+    REQUIRE((row_major.getElement(5 + 6*12 + 3*96) == 5 + 6*12 + 3*96));
+    const std::array<unsigned long,3> coord = z_order.getCoord(100);
+    REQUIRE((z_order.getElement(100) == row_major.getElement(coord)));
+  }
+
+  return 0;
+}
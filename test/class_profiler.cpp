@@ -0,0 +1,61 @@
+#include "profile.h"
+#include <thread>
+#include <vector>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+int main() {
+
+  // TEST: Counters are only updated while profiling is enabled
+  {
+    Profiler::enable(false);
+    Profiler::reset();
+    REQUIRE((Profiler::counts() == nullptr));
+    Profiler::enable(true);
+    REQUIRE((Profiler::counts() != nullptr));
+  }
+
+  // TEST: Counters of ended threads are merged with the counters of the calling thread
+  {
+    Profiler::enable(true);
+    Profiler::reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t){
+      threads.emplace_back([t](){
+        ProfileCounts* counts = Profiler::counts();
+        counts->tree_nodes += 10;
+        counts->split_vxls[2] += 1;
+        counts->flood_stack_max = 5 + t;
+      });
+    }
+    for (std::thread& t : threads){t.join();}
+    Profiler::counts()->tree_nodes += 1;
+    const ProfileCounts counts = Profiler::collectCounts();
+    REQUIRE((counts.tree_nodes == 41));
+    REQUIRE((counts.split_vxls[2] == 4));
+    REQUIRE((counts.flood_stack_max == 8));
+  }
+
+  // TEST: Reset clears the counters and the stages
+  {
+    Profiler::enable(true);
+    {Profiler::ScopedStage stage("test");}
+    REQUIRE((Profiler::collectStages().size() == 1));
+    REQUIRE((Profiler::collectStages()[0].name == "test"));
+    Profiler::reset();
+    REQUIRE(Profiler::collectStages().empty());
+    REQUIRE((Profiler::collectCounts().tree_nodes == 0));
+  }
+
+  // TEST: The split voxels are listed up to the highest level with a split voxel
+  {
+    ProfileCounts counts;
+    counts.split_vxls[1] = 3;
+    counts.shells_scanned = 7;
+    const std::string json = Profiler::toJson({}, counts);
+    REQUIRE((json == "{\"stages\":[],\"counters\":{\"split_voxels\":[0,3],\"tree_nodes\":0,\"shells_scanned\":7,\"flood_fill_stack_max\":0}}"));
+  }
+
+  return 0;
+}
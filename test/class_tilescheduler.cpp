@@ -0,0 +1,69 @@
+#include "tiling.h"
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+int main() {
+
+  const TileScheduler::index_type n_elements = {7,5,3};
+
+  // TEST: Tiles cover the index space without gaps or overlap
+  {
+    const TileScheduler scheduler(n_elements, 2, 1);
+    std::vector<int> visits(7*5*3, 0);
+    for (size_t i = 0; i < scheduler.size(); ++i){
+      const TileScheduler::Tile& tile = scheduler.getTile(i);
+      for (unsigned x = tile.start[0]; x < tile.end[0]; ++x){
+        for (unsigned y = tile.start[1]; y < tile.end[1]; ++y){
+          for (unsigned z = tile.start[2]; z < tile.end[2]; ++z){
+            visits[x + 7*(y + 5*z)]++;
+          }
+        }
+      }
+    }
+    bool all_once = true;
+    for (int v : visits){all_once &= v == 1;}
+    REQUIRE(all_once);
+    REQUIRE((scheduler.size() == 4*3*2));
+  }
+
+  // TEST: Every tile is processed exactly once by the worker threads
+  {
+    TileScheduler scheduler(n_elements, 1, 4);
+    std::vector<std::atomic<int>> visits(scheduler.size());
+    scheduler.run([&](const TileScheduler::Tile& tile, const unsigned thread_id){
+      visits[tile.start[0] + 7*(tile.start[1] + 5*tile.start[2])]++;
+    });
+    bool all_once = true;
+    for (const auto& v : visits){all_once &= v == 1;}
+    REQUIRE(all_once);
+  }
+
+  // TEST: Progress function can stop the scheduler
+  {
+    TileScheduler scheduler(n_elements, 1, 1);
+    int n_processed = 0;
+    scheduler.run([&](const TileScheduler::Tile&, const unsigned){n_processed++;},
+        [](const double fraction){return fraction < 0.5;});
+    REQUIRE(scheduler.isStopped());
+    REQUIRE((n_processed < int(scheduler.size())));
+  }
+
+  // TEST: Exceptions thrown in a worker thread are passed on to the caller
+  {
+    TileScheduler scheduler(n_elements, 1, 3);
+    bool caught = false;
+    try {
+      scheduler.run([](const TileScheduler::Tile& tile, const unsigned){
+        if (tile.start[0] == 3){throw std::runtime_error("test");}
+      });
+    }
+    catch (const std::runtime_error&){caught = true;}
+    REQUIRE(caught);
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include "distancetransform.h"
+#include <vector>
+#include <array>
+#include <random>
+#include <algorithm>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+// compares every element with every source
+std::vector<uint16_t> bruteForce(const std::vector<bool>& sources, const std::array<unsigned long,3>& n){
+  std::vector<uint16_t> result(sources.size(), s_max_sq_dist);
+  for (unsigned long i = 0; i < sources.size(); i++){
+    const long x = i % n[0], y = (i / n[0]) % n[1], z = i / (n[0]*n[1]);
+    long min_dist = s_max_sq_dist;
+    for (unsigned long j = 0; j < sources.size(); j++){
+      if (!sources[j]){continue;}
+      const long dx = x - long(j % n[0]), dy = y - long((j / n[0]) % n[1]), dz = z - long(j / (n[0]*n[1]));
+      min_dist = std::min(min_dist, dx*dx + dy*dy + dz*dz);
+    }
+    result[i] = min_dist;
+  }
+  return result;
+}
+
+std::vector<uint16_t> transform(const std::vector<bool>& sources, const std::array<unsigned long,3>& n){
+  std::vector<uint16_t> grid(sources.size());
+  for (unsigned long i = 0; i < sources.size(); i++){
+    grid[i] = sources[i]? 0 : s_max_sq_dist;
+  }
+  squaredDistanceTransform(grid, n);
+  return grid;
+}
+
+int main() {
+
+  std::mt19937 gen(7);
+
+  // TEST: The transform of random grids with different source densities is exact
+  {
+    bool all_equal = true;
+    for (int trial = 0; trial < 60; trial++){
+      const std::array<unsigned long,3> n = {1ul + trial % 13, 1ul + trial % 7, 1ul + trial % 11};
+      std::bernoulli_distribution is_source(0.02 * (trial % 5));
+      std::vector<bool> sources(n[0]*n[1]*n[2]);
+      for (unsigned long i = 0; i < sources.size(); i++){
+        sources[i] = is_source(gen);
+      }
+      all_equal &= transform(sources, n) == bruteForce(sources, n);
+    }
+    REQUIRE(all_equal);
+  }
+
+  // TEST: Grids without sources are at the maximum distance everywhere
+  {
+    const std::array<unsigned long,3> n = {5, 4, 3};
+    const std::vector<uint16_t> grid = transform(std::vector<bool>(60, false), n);
+    REQUIRE(std::all_of(grid.begin(), grid.end(), [](uint16_t d){return d == s_max_sq_dist;}));
+  }
+
+  // TEST: Distances beyond the maximum are capped
+  {
+    const std::array<unsigned long,3> n = {300, 3, 2};
+    std::vector<bool> sources(n[0]*n[1]*n[2], false);
+    sources[0] = true;
+    const std::vector<uint16_t> grid = transform(sources, n);
+    REQUIRE((grid == bruteForce(sources, n)));
+    REQUIRE((grid[255] == 255*255));
+    REQUIRE((grid[256] == s_max_sq_dist));
+  }
+
+  return 0;
+}
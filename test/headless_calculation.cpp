@@ -0,0 +1,136 @@
+#include "model.h"
+#include <string>
+#include <algorithm>
+#include <vector>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+// results of two calculations are identical, including the values of every cavity
+static bool sameResults(const CalcReportBundle& a, const CalcReportBundle& b){
+  if (!a.success || !b.success || a.volumes != b.volumes || a.cavities.size() != b.cavities.size()){return false;}
+  if (a.surf_vdw != b.surf_vdw || a.surf_molecular != b.surf_molecular
+      || a.surf_probe_excluded != b.surf_probe_excluded || a.surf_probe_accessible != b.surf_probe_accessible){
+    return false;
+  }
+  for (size_t i = 0; i < a.cavities.size(); ++i){
+    const Cavity& cav_a = a.cavities[i];
+    const Cavity& cav_b = b.cavities[i];
+    if (cav_a.id != cav_b.id || cav_a.core_vol != cav_b.core_vol || cav_a.shell_vol != cav_b.shell_vol
+        || cav_a.surf_core != cav_b.surf_core || cav_a.surf_shell != cav_b.surf_shell
+        || cav_a.min_index != cav_b.min_index || cav_a.max_index != cav_b.max_index){
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+
+  CalcParameters param;
+  param.atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/isobutane.xyz";
+  param.elem_file_path = std::string(MOLOVOL_INPUT_DIR) + "/elements.txt";
+  param.grid_step = 0.2;
+  param.max_depth = 3;
+  param.calc_surface_areas = true;
+
+  // TEST: A calculation without user interface gives the same result when it is repeated
+  double vdw_volume;
+  {
+    Model model;
+    const CalcReportBundle first = model.calculate(param);
+    const CalcReportBundle second = model.calculate(param);
+    REQUIRE(first.success);
+    REQUIRE(second.success);
+    vdw_volume = first.volumes.at(0b00000011);
+    REQUIRE((vdw_volume > 0));
+    REQUIRE((first.volumes == second.volumes));
+    REQUIRE((first.surf_vdw == second.surf_vdw));
+    REQUIRE((first.surf_vdw > 0));
+    REQUIRE(model.getReporter().getErrors().empty());
+  }
+
+  // TEST: Radii of the radius map replace the radii of the elements file, only for that calculation
+  {
+    Model model;
+    CalcParameters larger_carbon = param;
+    larger_carbon.radius_map["C"] = 2.5;
+    const CalcReportBundle larger = model.calculate(larger_carbon);
+    const CalcReportBundle reference = model.calculate(param);
+    REQUIRE((larger.volumes.at(0b00000011) > vdw_volume));
+    REQUIRE((reference.volumes.at(0b00000011) == vdw_volume));
+  }
+
+  // TEST: Errors are kept by the reporter of the model
+  {
+    Model model;
+    CalcParameters missing = param;
+    missing.atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/missing.xyz";
+    REQUIRE(!model.calculate(missing).success);
+    CalcParameters wrong_extension = param;
+    wrong_extension.atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/elements.txt";
+    REQUIRE(!model.calculate(wrong_extension).success);
+    const auto& errors = model.getReporter().getErrors();
+    REQUIRE((errors.size() == 2));
+    REQUIRE((errors[0].first == 102));
+    REQUIRE((errors[1].first == 103));
+  }
+
+  // TEST: A calculation can be repeated after a failed calculation
+  {
+    Model model;
+    CalcParameters missing = param;
+    missing.atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/missing.xyz";
+    model.calculate(missing);
+    const CalcReportBundle data = model.calculate(param);
+    REQUIRE(data.success);
+    REQUIRE((data.volumes.at(0b00000011) == vdw_volume));
+  }
+
+  // structures for comparing the options of the calculation: a crystal unit cell and a cage in two-probe mode
+  std::vector<CalcParameters> structures(2, param);
+  structures[0].atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/porous_crystals/paddelwheel-cage.cif";
+  structures[0].analyze_unit_cell = true;
+  structures[0].grid_step = 0.5;
+  structures[1].atom_file_path = std::string(MOLOVOL_INPUT_DIR) + "/Pd6L4_open_cage_Fujita.xyz";
+  structures[1].probe_mode = true;
+  structures[1].r_probe2 = 4;
+  structures[1].grid_step = 0.5;
+
+  // reference results with a single thread on the dense grid
+  std::vector<CalcReportBundle> references;
+  for (const CalcParameters& structure : structures){
+    Model model;
+    references.push_back(model.calculate(structure));
+    REQUIRE(!references.back().cavities.empty());
+  }
+
+  // TEST: Calculations on several threads give the same results as on a single thread
+  for (size_t i = 0; i < structures.size(); ++i){
+    Model model;
+    CalcParameters parallel = structures[i];
+    parallel.n_threads = 4;
+    REQUIRE(sameResults(references[i], model.calculate(parallel)));
+  }
+
+  // TEST: The sparse grid gives the same results as the dense grid
+  for (size_t i = 0; i < structures.size(); ++i){
+    Model model;
+    CalcParameters sparse = structures[i];
+    sparse.sparse_grid = true;
+    REQUIRE(sameResults(references[i], model.calculate(sparse)));
+  }
+
+  // TEST: Skipping neighbour shells with the distance transform does not change the results. the large
+  // probe of the cage reaches the border of the grid, where fewer shells may be skipped
+  for (size_t i = 0; i < structures.size(); ++i){
+    Model model;
+    CalcParameters distance_transform = structures[i];
+    distance_transform.distance_transform = true;
+    REQUIRE(sameResults(references[i], model.calculate(distance_transform)));
+    distance_transform.n_threads = 4;
+    REQUIRE(sameResults(references[i], model.calculate(distance_transform)));
+  }
+
+  return 0;
+}
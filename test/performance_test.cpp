@@ -3,91 +3,185 @@
 #include "atom.h"
 #include "space.h"
 #include "model.h"
-#include "importmanager.h"
+#include "profile.h"
 #include <vector>
 #include <string>
+#include <map>
 #include <cmath>
 
+// structure files are read from the source tree, the elements and space group files from the
+// resource folder, which is copied into the build directory
+#ifndef MOLOVOL_INPUT_DIR
+#define MOLOVOL_INPUT_DIR "inputfile"
+#endif
+
+// bundled structures: a protein, a crystal of metal-organic cages and a covalent organic framework.
+// the second value states whether the file contains a unit cell
+static const std::vector<std::pair<std::string,bool>> s_structures = {
+  {"6s8y.xyz", false},
+  {"porous_crystals/paddelwheel-cage.cif", true},
+  {"porous_crystals/COF300.cif", true},
+};
+
+// sums the wall time of every stage over the iterations of a benchmark
+static void addStageTimes(std::map<std::string,double>& sums, const std::vector<StageTime>& stages){
+  for (const StageTime& stage : stages){
+    sums[stage.name] += stage.wall_seconds;
+  }
+}
+
+// reports the average stage times per iteration and the number of bottom level voxels per second
+static void reportCounters(benchmark::State& state, const std::map<std::string,double>& stage_sums, const double n_vxl){
+  for (const auto& [name, seconds] : stage_sums){
+    state.counters["t_" + name] = benchmark::Counter(seconds, benchmark::Counter::kAvgIterations);
+  }
+  state.counters["voxels"] = n_vxl;
+  state.counters["voxels_per_second"] = benchmark::Counter(n_vxl * state.iterations(), benchmark::Counter::kIsRate);
+}
+
 // Performance test for Vector class operations
 static void BM_VectorOperations(benchmark::State& state) {
   Vector vec1(1.2, 2.4, 3.6);
   Vector vec2(6.0, 4.8, 3.0);
 
   for (auto _ : state) {
-    Vector sum = vec1 + vec2;
-    Vector diff = vec1 - vec2;
-    Vector scaled = vec1 * 2.0;
-    double length = vec1.length();
-    double dot_product = vec1 * vec2;
-    double distance = Vector::distance(vec1, vec2);
+    benchmark::DoNotOptimize(vec1 + vec2);
+    benchmark::DoNotOptimize(vec1 - vec2);
+    benchmark::DoNotOptimize(vec1 * 2.0);
+    benchmark::DoNotOptimize(vec1.length());
+    benchmark::DoNotOptimize(vec1 * vec2);
+    benchmark::DoNotOptimize((vec1 - vec2).length());
   }
 }
 BENCHMARK(BM_VectorOperations);
 
 // Performance test for Atom class operations
 static void BM_AtomOperations(benchmark::State& state) {
-  Atom atom1("C", {1.0, 2.0, 3.0}, 1.7, 6);
-  Atom atom2("O", {4.0, 5.0, 6.0}, 1.52, 8);
+  Atom atom1(1.0, 2.0, 3.0, "C", 1.7, 6);
+  Atom atom2(4.0, 5.0, 6.0, "O", 1.52, 8);
 
   for (auto _ : state) {
-    double distance = Vector::distance(atom1.getPosVec(), atom2.getPosVec());
-    double radius_sum = atom1.getRad() + atom2.getRad();
-    double atomic_number_sum = atom1.number + atom2.number;
+    benchmark::DoNotOptimize((atom1.getPosVec() - atom2.getPosVec()).length());
+    benchmark::DoNotOptimize(atom1.getRad() + atom2.getRad());
+    benchmark::DoNotOptimize(atom1.number + atom2.number);
   }
 }
 BENCHMARK(BM_AtomOperations);
 
-// Performance test for Space class operations
-static void BM_SpaceOperations(benchmark::State& state) {
-  std::vector<Atom> atoms = {
-    Atom("C", {1.0, 2.0, 3.0}, 1.7, 6),
-    Atom("O", {4.0, 5.0, 6.0}, 1.52, 8),
-    Atom("H", {7.0, 8.0, 9.0}, 1.2, 1)
-  };
-
-  double grid_size = 0.2;
-  int depth = 4;
-  double r_probe = 1.4;
-  bool unit_cell_option = false;
-  std::array<double, 3> unit_cell_axes = {0, 0, 0};
-
-  Space space(atoms, grid_size, depth, r_probe, unit_cell_option, unit_cell_axes);
+// Performance test for the type assignment of a cubic lattice of carbon atoms with a varying number of
+// atoms along each axis. every eighth lattice site is left empty, so that the lattice contains cavities
+static void BM_SpaceTypeAssignment(benchmark::State& state) {
+  const int n_side = state.range(0);
+  const double grid_size = state.range(1) / 100.0;
+  const int depth = 4;
+  const double r_probe = 1.2;
+  std::vector<Atom> atoms;
+  for (int x = 0; x < n_side; x++){
+    for (int y = 0; y < n_side; y++){
+      for (int z = 0; z < n_side; z++){
+        if (x%2 && y%2 && z%2){continue;}
+        atoms.push_back(Atom(3.0*x, 3.0*y, 3.0*z, "C", 1.7, 6));
+      }
+    }
+  }
 
+  std::map<std::string,double> stage_sums;
+  double n_vxl = 0;
   for (auto _ : state) {
-    space.assignTypeInGrid(atoms, {}, 1.4, 0, false, false);
+    Profiler::reset();
+    Space space(atoms, grid_size, depth, r_probe, false, {0, 0, 0});
+    std::vector<Cavity> cavities;
+    bool cavities_exceeded = false;
+    space.assignTypeInGrid(atoms, cavities, r_probe, 0, false, cavities_exceeded);
+    benchmark::DoNotOptimize(cavities.data());
+    n_vxl = space.totalVxlOnLvl(0);
+    addStageTimes(stage_sums, Profiler::collectStages());
   }
+  state.counters["atoms"] = atoms.size();
+  reportCounters(state, stage_sums, n_vxl);
 }
-BENCHMARK(BM_SpaceOperations);
+BENCHMARK(BM_SpaceTypeAssignment)
+  ->ArgNames({"atoms_per_side", "grid_pm"})
+  ->ArgsProduct({{4, 8, 16}, {40, 20}})
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
 
-// Performance test for Model class operations
-static void BM_ModelOperations(benchmark::State& state) {
-  std::string elements_file_path = "inputfile/elements.txt";
-  std::string structure_file_path = "inputfile/example_C60.xyz";
+// Performance test for the full calculation of a bundled structure. the arguments are the index
+// of the structure, the grid step in pm, the maximum depth, whether two probes are used,
+// whether the unit cell is analysed and whether surface areas are calculated
+static void BM_Structure(benchmark::State& state) {
+  const auto& [structure, has_unit_cell] = s_structures[state.range(0)];
+  const std::string structure_file_path = std::string(MOLOVOL_INPUT_DIR) + "/" + structure;
+  const double grid_size = state.range(1) / 100.0;
+  const int depth = state.range(2);
+  const bool probe_mode = state.range(3);
+  const bool unit_cell = state.range(4);
+  const bool surfaces = state.range(5);
 
   Model model;
-  model.importElemFile(elements_file_path);
-  model.readAtomsFromFile(structure_file_path);
+  model.importElemFile(Model::getDefaultElemPath());
+  if (!model.readAtomsFromFile(structure_file_path, false)){
+    state.SkipWithError(("could not read " + structure_file_path).c_str());
+    return;
+  }
+  model.setParameters(structure_file_path, "", false, unit_cell, surfaces, probe_mode, 1.2, 3.0,
+      grid_size, depth, false, false, false, model.getRadiusMap(), model.listElementsInStructure());
 
+  std::map<std::string,double> stage_sums;
+  double n_vxl = 0;
   for (auto _ : state) {
-    model.generateData();
+    CalcReportBundle data = model.generateData();
+    if (!data.success){
+      state.SkipWithError("calculation failed");
+      return;
+    }
+    n_vxl = model.getSurfaceData().totalVxlOnLvl(0);
+    addStageTimes(stage_sums, data.stage_times);
+  }
+  double n_atoms = 0;
+  for (const auto& [symbol, count, radius] : model.generateAtomList()){
+    n_atoms += count;
+  }
+  state.SetLabel(structure);
+  state.counters["atoms"] = n_atoms;
+  reportCounters(state, stage_sums, n_vxl);
+}
+
+// every structure is calculated with a reference set of parameters and with each parameter changed
+// on its own: a finer grid, a shallower tree, a second probe, no surfaces and no unit cell
+static void structureCases(benchmark::internal::Benchmark* b){
+  for (long i = 0; i < long(s_structures.size()); i++){
+    const long unit_cell = s_structures[i].second;
+    b->Args({i, 40, 4, 0, unit_cell, 1});
+    b->Args({i, 20, 4, 0, unit_cell, 1});
+    b->Args({i, 40, 2, 0, unit_cell, 1});
+    b->Args({i, 40, 4, 1, unit_cell, 1});
+    b->Args({i, 40, 4, 0, unit_cell, 0});
+    if (unit_cell){
+      b->Args({i, 40, 4, 0, 0, 1});
+    }
   }
 }
-BENCHMARK(BM_ModelOperations);
+BENCHMARK(BM_Structure)
+  ->ArgNames({"structure", "grid_pm", "depth", "two_probe", "unit_cell", "surface"})
+  ->Apply(structureCases)
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
 
 // Performance test for Model::processUnitCell
 static void BM_ModelProcessUnitCell(benchmark::State& state) {
-  std::string structure_file_path = "inputfile/example_C60.xyz";
-  std::string elements_file_path = "inputfile/elements.txt";
+  std::string structure_file_path = std::string(MOLOVOL_INPUT_DIR) + "/porous_crystals/COF300.cif";
 
   Model model;
-  model.importElemFile(elements_file_path);
-  model.readAtomsFromFile(structure_file_path);
+  model.importElemFile(Model::getDefaultElemPath());
+  model.readAtomsFromFile(structure_file_path, false);
+  model.setProbeRadii(1.2, 0, false);
 
   for (auto _ : state) {
     model.processUnitCell();
   }
 }
-BENCHMARK(BM_ModelProcessUnitCell);
+BENCHMARK(BM_ModelProcessUnitCell)->Unit(benchmark::kMillisecond);
 
 // Main function to run the benchmarks
 int main(int argc, char** argv) {
@@ -0,0 +1,59 @@
+#include "progress.h"
+#include <vector>
+#include <thread>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+int main() {
+
+  // TEST: Progress reported by several threads at the same time is counted exactly
+  {
+    ProgressToken progress;
+    progress.beginStage(CalcStage::shell);
+    progress.addWork(4*10000);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t){
+      threads.emplace_back([&progress](){
+        for (int i = 0; i < 10000; ++i){progress.addProgress();}
+      });
+    }
+    for (std::thread& t : threads){t.join();}
+    REQUIRE((progress.getProgress(CalcStage::shell) == 4*10000));
+    REQUIRE((progress.getFraction(CalcStage::shell) == 1));
+    REQUIRE((progress.getWork(CalcStage::atoms) == 0));
+    REQUIRE((progress.getFraction(CalcStage::atoms) == 0));
+  }
+
+  // TEST: Sampling notices an abort within one sampling interval
+  {
+    ProgressToken progress;
+    bool aborted = false;
+    for (unsigned i = 0; i < 2*ProgressToken::s_sample_interval; ++i){
+      aborted |= progress.sampleAbort();
+    }
+    REQUIRE(!aborted);
+    progress.requestAbort();
+    REQUIRE(progress.isAborted());
+    for (unsigned i = 0; i < ProgressToken::s_sample_interval; ++i){
+      aborted |= progress.sampleAbort();
+    }
+    REQUIRE(aborted);
+  }
+
+  // TEST: Reset clears the abort flag and the counters
+  {
+    ProgressToken progress;
+    progress.beginStage(CalcStage::surface);
+    progress.addWork(3);
+    progress.addProgress(2);
+    progress.requestAbort();
+    progress.reset();
+    REQUIRE(!progress.isAborted());
+    REQUIRE((progress.getStage() == CalcStage::atoms));
+    REQUIRE((progress.getWork(CalcStage::surface) == 0));
+    REQUIRE((progress.getProgress(CalcStage::surface) == 0));
+  }
+
+  return 0;
+}
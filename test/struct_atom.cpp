@@ -2,6 +2,7 @@
 #include <utility>
 #include <iostream>
 #include <chrono>
+#include <cstring>
 
 bool validateAtom(const Atom&, Atom::num_type, Atom::num_type, Atom::num_type, 
     Atom::symbol_type, Atom::num_type, Atom::atomic_num_type, Atom::charge_type);
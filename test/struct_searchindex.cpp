@@ -0,0 +1,123 @@
+#include "searchindex.h"
+#include <vector>
+#include <array>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+
+// Using this macro for future compatibility with Catch2
+# define REQUIRE(x) if (!x) return -1;
+
+// all unique combinations of three integers whose squares add up to n, as they were listed before the
+// shells were computed with integers only
+std::vector<std::array<unsigned int,3>> sumOfThreeSquares(unsigned long int n){
+  std::vector<std::array<unsigned int,3>> list_of_roots;
+  for (unsigned int x = 0; x <= std::sqrt(n); x++){
+    unsigned int diff = n - std::pow(x,2);
+    for (unsigned int y = x; y <= std::sqrt(diff); y++){
+      unsigned int z_sqr = diff - pow(y,2);
+      unsigned int z = std::sqrt(z_sqr);
+      if (z_sqr == std::pow(z,2) && z >= y){
+        list_of_roots.push_back({x,y,z});
+      }
+    }
+  }
+  return list_of_roots;
+}
+
+std::vector<std::array<int,3>> logPermutations(const std::array<unsigned int,3>);
+
+int main() {
+
+  const unsigned upp_lim = 300;
+  const SearchIndex::Shells shells = SearchIndex().computeIndices(upp_lim);
+
+  // TEST: Every shell holds exactly the indices whose squares add up to the shell number
+  {
+    bool all_in_shell = true;
+    bool all_found = true;
+    for (unsigned n = 0; n <= upp_lim; n++){
+      for (const std::array<int,3>& index : shells[n]){
+        all_in_shell &= unsigned(index[0]*index[0] + index[1]*index[1] + index[2]*index[2]) == n;
+      }
+    }
+    const int max_abs = std::sqrt(upp_lim);
+    size_t n_points = 0;
+    for (int x = -max_abs; x <= max_abs; x++){
+      for (int y = -max_abs; y <= max_abs; y++){
+        for (int z = -max_abs; z <= max_abs; z++){
+          n_points += unsigned(x*x + y*y + z*z) <= upp_lim;
+        }
+      }
+    }
+    size_t n_indices = 0;
+    for (const auto& shell : shells){n_indices += shell.size();}
+    all_found &= n_points == n_indices;
+    REQUIRE(all_in_shell);
+    REQUIRE(all_found);
+  }
+
+  // TEST: The shells list the indices in the same order as before, because the neighbour search
+  // takes the cavity id from the first core voxel that it finds
+  {
+    bool same_order = true;
+    for (unsigned n = 0; n <= upp_lim; n++){
+      std::vector<std::array<int,3>> shell;
+      for (const std::array<unsigned int,3>& roots : sumOfThreeSquares(n)){
+        const std::vector<std::array<int,3>> temp = logPermutations(roots);
+        shell.insert(shell.end(), temp.begin(), temp.end());
+      }
+      same_order &= shell == shells[n];
+    }
+    REQUIRE(same_order);
+  }
+
+  // TEST: Shells written to a cache file are read back unchanged and broken files are rejected
+  {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "molovol_test_searchindex";
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "shells.bin").string();
+    REQUIRE(SearchIndex::writeShells(path, shells));
+    SearchIndex::Shells read_shells;
+    REQUIRE(SearchIndex::readShells(path, upp_lim, read_shells));
+    REQUIRE((read_shells == shells));
+    REQUIRE(!SearchIndex::readShells(path, upp_lim+1, read_shells));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    REQUIRE(!SearchIndex::readShells(path, upp_lim, read_shells));
+    std::filesystem::remove_all(dir);
+  }
+
+  // TEST: Writers of the same cache file do not share a temporary file and leave none behind
+  {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "molovol_test_searchindex_concurrent";
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "shells.bin").string();
+    std::vector<char> written(8, false);
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < written.size(); ++i){
+      writers.emplace_back([&, i](){written[i] = SearchIndex::writeShells(path, shells);});
+    }
+    for (std::thread& writer : writers){
+      writer.join();
+    }
+    REQUIRE((std::count(written.begin(), written.end(), true) == long(written.size())));
+    SearchIndex::Shells read_shells;
+    REQUIRE(SearchIndex::readShells(path, upp_lim, read_shells));
+    REQUIRE((read_shells == shells));
+    REQUIRE((std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 1));
+    std::filesystem::remove_all(dir);
+  }
+
+  // TEST: Calculations with fewer shells share the shells of a larger calculation
+  {
+    const std::shared_ptr<const SearchIndex::Shells> large = SearchIndex::getShells(upp_lim);
+    const std::shared_ptr<const SearchIndex::Shells> small = SearchIndex::getShells(upp_lim/2);
+    REQUIRE((large == small));
+    REQUIRE((*large == shells));
+  }
+
+  return 0;
+}
@@ -2,6 +2,7 @@ import os
 import zipfile
 import re
 import shutil
+import functools
 from typing import Optional
 from uuid import uuid4
 from enum import Enum
@@ -420,7 +421,9 @@ def get_entry_size(entry_path):
 
     return total_size
 
-# Request the executable's version. If the executable is not found, then the web page crashes
+# Request the executable's version. If the executable is not found, then the web page crashes.
+# The version does not change while the server runs, so the executable is only launched once
+@functools.lru_cache(maxsize=None)
 def app_version():
     return subprocess.check_output(["./launch_headless.sh", "-v"], stderr=subprocess.STDOUT).decode("utf-8")
 